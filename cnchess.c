@@ -1,1039 +1,5671 @@
-#define NDEBUG
-
-#include <stdio.h>
-#include <stdlib.h>
-#include <string.h>
-#include <assert.h>
-#include <limits.h>
-
-/*
-	Chinese chess board is 10 x 9,
-	to speed up rules checking, I added 2 lines for both the top, left, bottom and right sides.
-*/
-#define BOARD_ROW_LEN 14
-#define BOARD_COL_LEN 13
-#define BOARD_ACTUAL_ROW_LEN 10
-#define BOARD_ACTUAL_COL_LEN 9
-#define BOARD_ACTUAL_ROW_BEGIN 2
-#define BOARD_ACTUAL_COL_BEGIN 2
-
-/* if a pawn has crossed the faced river, then he can move forward, left or right. */
-#define BOARD_RIVER_UP    (BOARD_ACTUAL_ROW_BEGIN + 4)
-#define BOARD_RIVER_DOWN  (BOARD_ACTUAL_ROW_BEGIN + 5)
-
-/* piece: general and advisor must stay within the 9 palace. */
-#define BOARD_9_PALACE_UP_TOP     (BOARD_ACTUAL_ROW_BEGIN)
-#define BOARD_9_PALACE_UP_BOTTOM  (BOARD_ACTUAL_ROW_BEGIN + 2)
-#define BOARD_9_PALACE_UP_LEFT    (BOARD_ACTUAL_COL_BEGIN + 3)
-#define BOARD_9_PALACE_UP_RIGHT   (BOARD_ACTUAL_COL_BEGIN + 5)
-
-#define BOARD_9_PALACE_DOWN_TOP     (BOARD_ACTUAL_ROW_BEGIN + 7)
-#define BOARD_9_PALACE_DOWN_BOTTOM  (BOARD_ACTUAL_ROW_BEGIN + 9)
-#define BOARD_9_PALACE_DOWN_LEFT    (BOARD_ACTUAL_COL_BEGIN + 3)
-#define BOARD_9_PALACE_DOWN_RIGHT   (BOARD_ACTUAL_COL_BEGIN + 5)
-
-/* 1024 means 512 rounds, I think this is big enough for one game. */
-#define MAX_HISOTRY_BUF_LEN 1024
-
-/* The max number of steps a player can take in a single turn. */
-#define MAX_ONE_SIDE_POSSIBLE_MOVES_LEN 256
-
-/* user input string length limitation. */
-#define MAX_USER_INPUT_BUFFER_LEN 8
-
-/* the length of buffer for converting a move to string. */
-#define MOVE_TO_STR_BUFFER_LEN 5
-
-/* compare max and min macros, never use function as parameter, otherwise the function will be called twice. */
-#define COMPARE_MAX(left, right) ((left) > (right) ? (left) : (right))
-#define COMPARE_MIN(left, right) ((left) < (right) ? (left) : (right))
-
-/* piece side. */
-enum PieceSide{
-    PS_UP,         /* upper side player. */
-    PS_DOWN,       /* down side player. */
-    PS_EXTRA       /* neither upper nor down, for example: empty or out of chess board. */
-};
-
-/* piece type. */
-enum PieceType{
-    PT_PAWN,       /* pawn. */
-    PT_CANNON,     /* cannon. */
-    PT_ROOK,       /* rook. */
-    PT_KNIGHT,     /* knight. */
-    PT_BISHOP,     /* bishop. */
-    PT_ADVISOR,    /* advisor. */
-    PT_GENERAL,    /* general. */
-    PT_EMPTY,      /* empty here. */
-    PT_OUT         /* out of chess board. */
-};
-
-/* piece. */
-enum Piece{
-    P_UP,              /* upper pawn. */
-    P_UC,              /* upper cannon. */
-    P_UR,              /* upper rook. */
-    P_UN,              /* upper knight. */
-    P_UB,              /* upper bishop. */
-    P_UA,              /* upper advisor. */
-    P_UG,              /* upper general. */
-    P_DP,              /* down pawn. */
-    P_DC,              /* down cannon. */
-    P_DR,              /* down rook. */
-    P_DN,              /* down knight. */
-    P_DB,              /* down bishop. */
-    P_DA,              /* down advisor. */
-    P_DG,              /* down general. */
-    P_EE,              /* empty. */
-    P_EO,              /* out of chess board. used for speeding up rules checking. */
-    PIECE_TOTAL_LEN    /* total number of pieces, you maybe never need this. */
-};
-
-static const char piece_get_char[] = {
-    /* cause #include<> just copy the content, so why not write those things to a txt file rather than writing in code ? */
-    #include "chessBoardPieceChar.txt"
-};
-
-static const enum PieceSide piece_get_side[] = {
-    PS_UP, PS_UP, PS_UP, PS_UP, PS_UP, PS_UP, PS_UP,
-    PS_DOWN, PS_DOWN, PS_DOWN, PS_DOWN, PS_DOWN, PS_DOWN, PS_DOWN,
-    PS_EXTRA, PS_EXTRA
-};
-
-static const enum PieceType piece_get_type[] = {
-    PT_PAWN, PT_CANNON, PT_ROOK, PT_KNIGHT, PT_BISHOP, PT_ADVISOR, PT_GENERAL,
-    PT_PAWN, PT_CANNON, PT_ROOK, PT_KNIGHT, PT_BISHOP, PT_ADVISOR, PT_GENERAL,
-    PT_EMPTY, PT_OUT
-};
-
-static const enum PieceSide piece_side_get_reverse_side[] = {
-    PS_DOWN,     /* upper side reverse is down. */
-    PS_UP,       /* down side reverse is up. */
-    PS_EXTRA     /* extra remains extra. */
-};
-
-/*
-	every piece's value. 
-	upper side piece's value is negative, down side is positive. 
-*/
-static const int piece_get_value[] = {
-    #include "chessBoardPieceValue.txt"
-};
-
-/* 
-	every piece's position value on the chess board. 
-	upper side piece's value is negative, down side is positive. 
-*/
-static const int piece_get_pos_value[][BOARD_ACTUAL_ROW_LEN][BOARD_ACTUAL_COL_LEN] = {
-    #include "chessBoardPosValue.txt"
-};
-
-/* 
-    a default chess board, used as a template for new board.
-    P_EO is used here for speeding up rules checking.
-*/
-static const enum Piece CHESS_BOARD_DEFAULT_TEMPLATE[BOARD_ROW_LEN][BOARD_COL_LEN] = {
-    { P_EO, P_EO, P_EO, P_EO, P_EO, P_EO, P_EO, P_EO, P_EO, P_EO, P_EO, P_EO, P_EO },
-    { P_EO, P_EO, P_EO, P_EO, P_EO, P_EO, P_EO, P_EO, P_EO, P_EO, P_EO, P_EO, P_EO },
-    { P_EO, P_EO, P_UR, P_UN, P_UB, P_UA, P_UG, P_UA, P_UB, P_UN, P_UR, P_EO, P_EO },
-    { P_EO, P_EO, P_EE, P_EE, P_EE, P_EE, P_EE, P_EE, P_EE, P_EE, P_EE, P_EO, P_EO },
-    { P_EO, P_EO, P_EE, P_UC, P_EE, P_EE, P_EE, P_EE, P_EE, P_UC, P_EE, P_EO, P_EO },
-    { P_EO, P_EO, P_UP, P_EE, P_UP, P_EE, P_UP, P_EE, P_UP, P_EE, P_UP, P_EO, P_EO },
-    { P_EO, P_EO, P_EE, P_EE, P_EE, P_EE, P_EE, P_EE, P_EE, P_EE, P_EE, P_EO, P_EO },
-    { P_EO, P_EO, P_EE, P_EE, P_EE, P_EE, P_EE, P_EE, P_EE, P_EE, P_EE, P_EO, P_EO },
-    { P_EO, P_EO, P_DP, P_EE, P_DP, P_EE, P_DP, P_EE, P_DP, P_EE, P_DP, P_EO, P_EO },
-    { P_EO, P_EO, P_EE, P_DC, P_EE, P_EE, P_EE, P_EE, P_EE, P_DC, P_EE, P_EO, P_EO },
-    { P_EO, P_EO, P_EE, P_EE, P_EE, P_EE, P_EE, P_EE, P_EE, P_EE, P_EE, P_EO, P_EO },
-    { P_EO, P_EO, P_DR, P_DN, P_DB, P_DA, P_DG, P_DA, P_DB, P_DN, P_DR, P_EO, P_EO },
-    { P_EO, P_EO, P_EO, P_EO, P_EO, P_EO, P_EO, P_EO, P_EO, P_EO, P_EO, P_EO, P_EO },
-    { P_EO, P_EO, P_EO, P_EO, P_EO, P_EO, P_EO, P_EO, P_EO, P_EO, P_EO, P_EO, P_EO },
-};
-
-/* move node, reprensent a move. */
-struct MoveNode{
-    int beginRow;
-    int beginCol;
-    int endRow;
-    int endCol;
-};
-
-/* history node, used for undo the previous move. */
-struct HistoryNode{
-    struct MoveNode move;
-    enum Piece beginPiece;
-    enum Piece endPiece;
-};
-
-/* chess board. */
-struct ChessBoard{
-    enum Piece data[BOARD_ROW_LEN][BOARD_COL_LEN];
-    struct HistoryNode history[MAX_HISOTRY_BUF_LEN];
-    size_t historyLength;
-};
-
-/* possible moves. */
-struct PossibleMoves{
-    struct MoveNode data[MAX_ONE_SIDE_POSSIBLE_MOVES_LEN];
-    size_t len;
-};
-
-/* 
-    wrapper on malloc().
-    if out of memory, then log the error and exit the program. 
-    you should call free() on the returned value later.
-*/
-static void* safe_malloc(size_t size){
-    void* buffer = malloc(size);
-    if (buffer == NULL){
-        fprintf(stderr, "%s: %s(%d) error: malloc() out of memory\n", __FILE__, __FUNCTION__, __LINE__);
-        exit(EXIT_FAILURE);
-    }
-
-    return buffer;
-}
-
-/* 
-    making a new chess board. 
-    you should call free() on the returned value later.
-*/
-static struct ChessBoard* board_make_new(void){
-    struct ChessBoard* cb = (struct ChessBoard*)safe_malloc(sizeof(struct ChessBoard));
-    memcpy(cb->data, &CHESS_BOARD_DEFAULT_TEMPLATE, BOARD_ROW_LEN * BOARD_COL_LEN * sizeof(enum Piece));
-    cb->historyLength = 0;
-
-    return cb;
-}
-
-static void board_print_to_console(const struct ChessBoard* cb){
-    assert(cb != NULL);
-
-    int splitLineIndex = BOARD_ACTUAL_ROW_BEGIN + (BOARD_ACTUAL_ROW_LEN / 2);
-    int endRow = BOARD_ACTUAL_ROW_BEGIN + BOARD_ACTUAL_ROW_LEN;
-    int endCol = BOARD_ACTUAL_COL_BEGIN + BOARD_ACTUAL_COL_LEN;
-    int n = BOARD_ACTUAL_ROW_LEN - 1;
-
-    printf("\n    +-------------------+\n");
-
-    int r, c;
-    for (r = BOARD_ACTUAL_ROW_BEGIN; r < endRow; ++r) {
-        if (r == splitLineIndex){
-            printf("    |===================|\n");
-            printf("    |===================|\n");
-        }
-
-        printf(" %d  | ", n--);
-
-        for (c = BOARD_ACTUAL_COL_BEGIN; c < endCol; ++c){
-            printf("%c ", piece_get_char[(cb->data[r][c])]);
-        }
-
-        printf("|\n");
-    }
-
-    printf("    +-------------------+\n");
-    printf("\n      a b c d e f g h i\n\n");
-}
-
-/* record history and move, never check any game rules. */
-static void board_move(struct ChessBoard* cb, const struct MoveNode* moveNode){
-    assert(cb != NULL && moveNode != NULL);
-
-    enum Piece beginPiece = cb->data[moveNode->beginRow][moveNode->beginCol];
-    enum Piece endPiece = cb->data[moveNode->endRow][moveNode->endCol];
-
-    /* first, historyLength too big is considered as a draw, then exit the program. */
-    if (cb->historyLength == MAX_HISOTRY_BUF_LEN){
-        free(cb);
-        printf("Draw: You have been battling with AI for a very long time and have exceeded the max number of rounds in this game.");
-        exit(EXIT_SUCCESS);
-    }
-
-    /* record the history. */
-    struct HistoryNode* currentHistoryNode = &(cb->history[cb->historyLength]);
-    memcpy(currentHistoryNode, moveNode, sizeof(struct MoveNode));
-    currentHistoryNode->beginPiece = beginPiece;
-    currentHistoryNode->endPiece = endPiece;
-
-    ++(cb->historyLength);
-
-    /* move the pieces. */
-    cb->data[moveNode->beginRow][moveNode->beginCol] = P_EE;
-    cb->data[moveNode->endRow][moveNode->endCol] = beginPiece;
-}
-
-/* undo the previous move, if history is empty, do nothing. */
-static void board_undo(struct ChessBoard* cb){
-    assert(cb != NULL);
-
-    if (cb->historyLength > 0){
-        --(cb->historyLength);
-        struct HistoryNode* hist = &(cb->history[cb->historyLength]);
-
-        cb->data[hist->move.beginRow][hist->move.beginCol] = hist->beginPiece;
-        cb->data[hist->move.endRow][hist->move.endCol] = hist->endPiece;
-    }
-}
-
-static void possible_move_insert(struct PossibleMoves* pm, int beginRow, int beginCol, int endRow, int endCol){
-    assert(pm != NULL);
-
-    struct MoveNode* currentMoveNode = &(pm->data[pm->len]);
-
-    currentMoveNode->beginRow = beginRow;
-    currentMoveNode->beginCol = beginCol;
-    currentMoveNode->endRow = endRow;
-    currentMoveNode->endCol = endCol;
-
-    ++(pm->len);
-}
-
-static void board_try_insert_possible_move(struct ChessBoard* cb, struct PossibleMoves* pm, int beginRow, int beginCol, int endRow, int endCol){
-    assert(cb != NULL && pm != NULL);
-
-    enum Piece beginP = cb->data[beginRow][beginCol];
-    enum Piece endP = cb->data[endRow][endCol];
-
-    if (endP != P_EO && piece_get_side[beginP] != piece_get_side[endP]){   /* not out of chess board, and not the same side. */
-        possible_move_insert(pm, beginRow, beginCol, endRow, endCol);
-    }
-}
-
-static void board_gen_possible_moves_for_pawn(struct ChessBoard* cb, struct PossibleMoves* pm, int r, int c, enum PieceSide side){
-	assert(cb != NULL && pm != NULL);
-
-    if (side == PS_UP){
-        board_try_insert_possible_move(cb, pm,  r, c, r + 1, c);
-
-        if (r > BOARD_RIVER_UP){    /* cross the river ? */
-            board_try_insert_possible_move(cb, pm, r, c, r, c - 1);
-            board_try_insert_possible_move(cb, pm, r, c, r, c + 1);
-        }
-    }
-    else if (side == PS_DOWN){
-        board_try_insert_possible_move(cb, pm, r, c, r - 1, c);
-
-        if (r < BOARD_RIVER_DOWN){
-            board_try_insert_possible_move(cb, pm, r, c, r, c - 1);
-            board_try_insert_possible_move(cb, pm, r, c, r, c + 1);
-        }
-    }
-}
-
-static void board_gen_possible_moves_for_cannon_one_direction(struct ChessBoard* cb, struct PossibleMoves* pm, int r, int c, int rGap, int cGap, enum PieceSide side){
-    assert(cb != NULL && pm != NULL);
-
-    int row, col;
-    enum Piece p;
-
-    for (row = r + rGap, col = c + cGap; ;row += rGap, col += cGap){
-        p = cb->data[row][col];
-
-        if (p == P_EE){    /* empty piece, then insert it. */
-            possible_move_insert(pm, r, c, row, col);
-        }
-        else {   /* upper piece, down piece or out of chess board, break immediately. */
-            break;
-        }
-    }
-
-    if (p != P_EO){   /* not out of chess board, check if we can add an enemy piece. */
-        for (row = row + rGap, col = col + cGap; ;row += rGap, col += cGap){
-            p = cb->data[row][col];
-        
-            if (p == P_EE){    /* empty, then continue search. */
-                continue;
-            }
-            else if (piece_get_side[p] == piece_side_get_reverse_side[side]){   /* enemy piece, then insert it and break. */
-                possible_move_insert(pm, r, c, row, col);
-                break;
-            }
-            else {    /* self side piece or out of chess board, break. */
-                break;
-            }
-        }
-    }
-}
-
-static void board_gen_possible_moves_for_cannon(struct ChessBoard* cb, struct PossibleMoves* pm, int r, int c, enum PieceSide side){
-	assert(cb != NULL && pm != NULL);
-
-    /* go up, down, left, right. */
-    board_gen_possible_moves_for_cannon_one_direction(cb, pm, r, c, -1, 0, side);
-    board_gen_possible_moves_for_cannon_one_direction(cb, pm, r, c, +1, 0, side);
-    board_gen_possible_moves_for_cannon_one_direction(cb, pm, r, c, 0, -1, side);
-    board_gen_possible_moves_for_cannon_one_direction(cb, pm, r, c, 0, +1, side);
-}
-
-static void board_gen_possible_moves_for_rook_one_direction(struct ChessBoard* cb, struct PossibleMoves* pm, int r, int c, int rGap, int cGap, enum PieceSide side){
-    assert(cb != NULL && pm != NULL);
-
-    int row, col;
-    enum Piece p;
-
-    for (row = r + rGap, col = c + cGap; ;row += rGap, col += cGap){
-        p = cb->data[row][col];
-
-        if (p == P_EE){    /* empty piece, then insert it. */
-            possible_move_insert(pm, r, c, row, col);
-        }
-        else {   /* upper piece, down piece or out of chess board, break immediately. */
-            break;
-        }
-    }
-
-    if (piece_get_side[p] == piece_side_get_reverse_side[side]){   /* enemy piece, then insert it. */
-        possible_move_insert(pm, r, c, row, col);
-    }
-}
-
-static void board_gen_possible_moves_for_rook(struct ChessBoard* cb, struct PossibleMoves* pm, int r, int c, enum PieceSide side){
-	assert(cb != NULL && pm != NULL);
-
-    /* go up, down, left, right. */
-    board_gen_possible_moves_for_rook_one_direction(cb, pm, r, c, -1, 0, side);
-    board_gen_possible_moves_for_rook_one_direction(cb, pm, r, c, +1, 0, side);
-    board_gen_possible_moves_for_rook_one_direction(cb, pm, r, c, 0, -1, side);
-    board_gen_possible_moves_for_rook_one_direction(cb, pm, r, c, 0, +1, side);
-}
-
-static void board_gen_possible_moves_for_knight(struct ChessBoard* cb, struct PossibleMoves* pm, int r, int c, enum PieceSide side){
-	assert(cb != NULL && pm != NULL);
-
-    enum Piece p;
-    if ((p = cb->data[r + 1][c]) == P_EE){    /* if not lame horse leg ? */
-        board_try_insert_possible_move(cb, pm, r, c, r + 2, c + 1);
-        board_try_insert_possible_move(cb, pm, r, c, r + 2, c - 1);
-    }
-
-    if ((p = cb->data[r - 1][c]) == P_EE){
-        board_try_insert_possible_move(cb, pm, r, c, r - 2, c + 1);
-        board_try_insert_possible_move(cb, pm, r, c, r - 2, c - 1);
-    }
-
-    if ((p = cb->data[r][c + 1]) == P_EE){
-        board_try_insert_possible_move(cb, pm, r, c, r + 1, c + 2);
-        board_try_insert_possible_move(cb, pm, r, c, r - 1, c + 2);
-    }
-
-    if ((p = cb->data[r][c - 1]) == P_EE){
-        board_try_insert_possible_move(cb, pm, r, c, r + 1, c - 2);
-        board_try_insert_possible_move(cb, pm, r, c, r - 1, c - 2);
-    }
-}
-
-static void board_gen_possible_moves_for_bishop(struct ChessBoard* cb, struct PossibleMoves* pm, int r, int c, enum PieceSide side){
-	assert(cb != NULL && pm != NULL);
-
-    enum Piece p;
-    if (side == PS_UP){
-        if (r + 2 <= BOARD_RIVER_UP){       /* bishop can't cross river. */
-            if ((p = cb->data[r + 1][c + 1]) == P_EE){    /* bishop can move only if Xiang Yan is empty. */
-                board_try_insert_possible_move(cb, pm, r, c, r + 2, c + 2);
-            }
-
-            if ((p = cb->data[r + 1][c - 1]) == P_EE){
-                board_try_insert_possible_move(cb, pm, r, c, r + 2, c - 2);
-            }
-        }
-
-        if ((p = cb->data[r - 1][c + 1]) == P_EE){
-            board_try_insert_possible_move(cb, pm, r, c, r - 2, c + 2);
-        }
-
-        if ((p = cb->data[r - 1][c - 1]) == P_EE){
-            board_try_insert_possible_move(cb, pm, r, c, r - 2, c - 2);
-        }
-    }
-    else if (side == PS_DOWN){
-        if (r - 2 >= BOARD_RIVER_DOWN){
-            if ((p = cb->data[r - 1][c + 1]) == P_EE){
-                board_try_insert_possible_move(cb, pm, r, c, r - 2, c + 2);
-            }
-
-            if ((p = cb->data[r - 1][c - 1]) == P_EE){
-                board_try_insert_possible_move(cb, pm, r, c, r - 2, c - 2);
-            }
-        }
-
-        if ((p = cb->data[r + 1][c + 1]) == P_EE){
-            board_try_insert_possible_move(cb, pm, r, c, r + 2, c + 2);
-        }
-
-        if ((p = cb->data[r + 1][c - 1]) == P_EE){
-            board_try_insert_possible_move(cb, pm, r, c, r + 2, c - 2);
-        }
-    }
-}
-
-static void board_gen_possible_moves_for_advisor(struct ChessBoard* cb, struct PossibleMoves* pm, int r, int c, enum PieceSide side){
-	assert(cb != NULL && pm != NULL);
-
-    if (side == PS_UP){
-        if (r + 1 <= BOARD_9_PALACE_UP_BOTTOM && c + 1 <= BOARD_9_PALACE_UP_RIGHT) {   /* walk diagonal lines. */
-            board_try_insert_possible_move(cb, pm, r, c, r + 1, c + 1);
-        }
-
-        if (r + 1 <= BOARD_9_PALACE_UP_BOTTOM && c - 1 >= BOARD_9_PALACE_UP_LEFT) {
-            board_try_insert_possible_move(cb, pm, r, c, r + 1, c - 1);
-        }
-
-        if (r - 1 >= BOARD_9_PALACE_UP_TOP && c + 1 <= BOARD_9_PALACE_UP_RIGHT) {
-            board_try_insert_possible_move(cb, pm, r, c, r - 1, c + 1);
-        }
-
-        if (r - 1 >= BOARD_9_PALACE_UP_TOP && c - 1 >= BOARD_9_PALACE_UP_LEFT) {
-            board_try_insert_possible_move(cb, pm, r, c, r - 1, c - 1);
-        }
-    }
-    else if (side == PS_DOWN){
-        if (r + 1 <= BOARD_9_PALACE_DOWN_BOTTOM && c + 1 <= BOARD_9_PALACE_DOWN_RIGHT) {
-            board_try_insert_possible_move(cb, pm, r, c, r + 1, c + 1);
-        }
-
-        if (r + 1 <= BOARD_9_PALACE_DOWN_BOTTOM && c - 1 >= BOARD_9_PALACE_DOWN_LEFT) {
-            board_try_insert_possible_move(cb, pm, r, c, r + 1, c - 1);
-        }
-
-        if (r - 1 >= BOARD_9_PALACE_DOWN_TOP && c + 1 <= BOARD_9_PALACE_DOWN_RIGHT) {
-            board_try_insert_possible_move(cb, pm, r, c, r - 1, c + 1);
-        }
-
-        if (r - 1 >= BOARD_9_PALACE_DOWN_TOP && c - 1 >= BOARD_9_PALACE_DOWN_LEFT) {
-            board_try_insert_possible_move(cb, pm, r, c, r - 1, c - 1);
-        }
-    }
-}
-
-static void board_gen_possible_moves_for_general(struct ChessBoard* cb, struct PossibleMoves* pm, int r, int c, enum PieceSide side){
-	assert(cb != NULL && pm != NULL);
-    enum Piece p;
-    int row;
-
-    if (side == PS_UP){
-        if (r + 1 <= BOARD_9_PALACE_UP_BOTTOM){   /* walk horizontal or vertical. */
-            board_try_insert_possible_move(cb, pm, r, c, r + 1, c);
-        }
-
-        if (r - 1 >= BOARD_9_PALACE_UP_TOP){
-            board_try_insert_possible_move(cb, pm, r, c, r - 1, c);
-        }
-
-        if (c + 1 <= BOARD_9_PALACE_UP_RIGHT){
-            board_try_insert_possible_move(cb, pm, r, c, r, c + 1);
-        }
-
-        if (c - 1 >= BOARD_9_PALACE_UP_LEFT){
-            board_try_insert_possible_move(cb, pm, r, c, r, c - 1);
-        }
-
-        /* check if both generals faced each other directly. */
-        for (row = r + 1; row < BOARD_ACTUAL_ROW_BEGIN + BOARD_ACTUAL_ROW_LEN ;++row){
-            p = cb->data[row][c];
-
-            if (p == P_EE){
-                continue;
-            }
-            else if (p == P_DG){
-                possible_move_insert(pm, r, c, row, c);
-                break;
-            }
-            else {
-                break;
-            }
-        }
-    }
-    else if (side == PS_DOWN){
-        if (r + 1 <= BOARD_9_PALACE_DOWN_BOTTOM){
-            board_try_insert_possible_move(cb, pm, r, c, r + 1, c);
-        }
-
-        if (r - 1 >= BOARD_9_PALACE_DOWN_TOP){
-            board_try_insert_possible_move(cb, pm, r, c, r - 1, c);
-        }
-
-        if (c + 1 <= BOARD_9_PALACE_DOWN_RIGHT){
-            board_try_insert_possible_move(cb, pm, r, c, r, c + 1);
-        }
-
-        if (c - 1 >= BOARD_9_PALACE_DOWN_LEFT){
-            board_try_insert_possible_move(cb, pm, r, c, r, c - 1);
-        }
-
-        for (row = r - 1; row >= BOARD_ACTUAL_ROW_BEGIN ;--row){
-            p = cb->data[row][c];
-
-            if (p == P_EE){
-                continue;
-            }
-            else if (p == P_UG){
-                possible_move_insert(pm, r, c, row, c);
-                break;
-            }
-            else {
-                break;
-            }
-        }
-    }
-}
-
-/* 
-    generate possible moves for one side. 
-    you should call free() on the returned value later.
-*/
-static struct PossibleMoves* board_gen_possible_moves(struct ChessBoard* cb, enum PieceSide side){
-	assert(cb != NULL);
-	
-    struct PossibleMoves* pm = (struct PossibleMoves*)safe_malloc(sizeof(struct PossibleMoves));
-    pm->len = 0;
-
-    int endRow = BOARD_ACTUAL_ROW_BEGIN + BOARD_ACTUAL_ROW_LEN;
-    int endCol = BOARD_ACTUAL_COL_BEGIN + BOARD_ACTUAL_COL_LEN;
-
-    enum Piece p;
-    int r, c;
-    for (r = BOARD_ACTUAL_ROW_BEGIN; r < endRow; ++r) {
-        for (c = BOARD_ACTUAL_COL_BEGIN; c < endCol; ++c){
-            p = cb->data[r][c];
-
-            if (piece_get_side[p] == side){
-                switch (piece_get_type[p])
-                {
-                case PT_PAWN:
-                    board_gen_possible_moves_for_pawn(cb, pm, r, c, side);
-                    break;
-                case PT_CANNON:
-                    board_gen_possible_moves_for_cannon(cb, pm, r, c, side);
-                    break;
-                case PT_ROOK:
-                    board_gen_possible_moves_for_rook(cb, pm, r, c, side);
-                    break;
-                case PT_KNIGHT:
-                    board_gen_possible_moves_for_knight(cb, pm, r, c, side);
-                    break;
-                case PT_BISHOP:
-                    board_gen_possible_moves_for_bishop(cb, pm, r, c, side);
-                    break;
-                case PT_ADVISOR:
-                    board_gen_possible_moves_for_advisor(cb, pm, r, c, side);
-                    break;
-                case PT_GENERAL:
-                    board_gen_possible_moves_for_general(cb, pm, r, c, side);
-                    break;
-                case PT_EMPTY:
-                case PT_OUT:
-                default:
-                    break;
-                }
-            }
-        }
-    }
-
-    return pm;
-}
-
-/* 
-	calculate a chess board's score. 
-	upper side value is negative, down side is positive.
-*/
-static long board_calc_score(const struct ChessBoard* cb){
-	assert(cb != NULL);
-	
-    long totalScore = 0;
-
-    int endRow = BOARD_ACTUAL_ROW_BEGIN + BOARD_ACTUAL_ROW_LEN;
-    int endCol = BOARD_ACTUAL_COL_BEGIN + BOARD_ACTUAL_COL_LEN;
-
-    enum Piece p;
-    int r, c;
-    for (r = BOARD_ACTUAL_ROW_BEGIN; r < endRow; ++r) {
-        for (c = BOARD_ACTUAL_COL_BEGIN; c < endCol; ++c){
-            p = cb->data[r][c];
-
-			if (p != P_EE){
-				totalScore += piece_get_value[p];
-				totalScore += piece_get_pos_value[p][r - BOARD_ACTUAL_ROW_BEGIN][c - BOARD_ACTUAL_COL_BEGIN];	
-            }
-        }
-    }
-
-    return totalScore;
-}
-
-/* min-max algorithm, with alpha-beta pruning. */
-static int min_max(struct ChessBoard* cb, unsigned int searchDepth, int alpha, int beta, enum PieceSide side){
-    if (searchDepth == 0){
-        return board_calc_score(cb);
-    }
-
-    int minMaxValue;
-    if (side == PS_UP){
-        int minValue = INT_MAX;
-        struct MoveNode* node;
-        struct PossibleMoves* possibleMoves = board_gen_possible_moves(cb, PS_UP);
-
-        int i;
-        for (i = 0;i < possibleMoves->len;++i){
-            node = &(possibleMoves->data[i]);
-
-            board_move(cb, node);
-            minMaxValue = min_max(cb, searchDepth - 1, alpha, beta, PS_DOWN);
-            minValue = COMPARE_MIN(minValue, minMaxValue);
-            board_undo(cb);
-
-            beta = COMPARE_MIN(beta, minValue);
-            if (alpha >= beta){
-                break;
-            }
-        }
-
-        free(possibleMoves);
-        return minValue;
-    }
-    else if (side == PS_DOWN){
-        int maxValue = INT_MIN;
-        struct MoveNode* node;
-        struct PossibleMoves* possibleMoves = board_gen_possible_moves(cb, PS_DOWN);
-
-        int i;
-        for (i = 0;i < possibleMoves->len;++i){
-            node = &(possibleMoves->data[i]);
-
-            board_move(cb, node);
-            minMaxValue = min_max(cb, searchDepth - 1, alpha, beta, PS_UP);
-            maxValue = COMPARE_MAX(maxValue, minMaxValue);
-            board_undo(cb);
-
-            alpha = COMPARE_MAX(alpha, maxValue);
-            if (alpha >= beta){
-                break;
-            }
-        }
-
-        free(possibleMoves);
-        return maxValue;
-    }
-    else {   /* never need this, just for return value. */
-        return 0;
-    }
-}
-
-/* 
-    gen best move for one side. 
-    searchDepth is used as difficulty rank, the bigger it is, the more time the generation costs.
-    give param enum PieceSide: PS_EXTRA to this function is meaningless, you will always get a struct MoveNode object with {0, 0, 0, 0}.
-*/
-static void board_gen_best_move(struct ChessBoard* cb, enum PieceSide side, unsigned int searchDepth, struct MoveNode* bestMove){
-    assert(cb != NULL);
-
-    int i, value;
-    struct MoveNode* node;
-    struct PossibleMoves* possibleMoves;
-
-    if (side == PS_UP){
-        int minValue = INT_MAX;
-        possibleMoves = board_gen_possible_moves(cb, PS_UP);
-
-        for (i = 0;i < possibleMoves->len;++i){
-            node = &(possibleMoves->data[i]);
-
-            board_move(cb, node);
-            value = min_max(cb, searchDepth, INT_MIN, INT_MAX, PS_DOWN);
-            board_undo(cb);
-
-            if (value <= minValue){
-                minValue = value;
-                memcpy(bestMove, node, sizeof(struct MoveNode));
-            }
-        }
-
-        free(possibleMoves);
-    }
-    else if (side == PS_DOWN){
-        int maxValue = INT_MIN;
-        possibleMoves = board_gen_possible_moves(cb, PS_DOWN);
-
-        for (i = 0;i < possibleMoves->len;++i){
-            node = &(possibleMoves->data[i]);
-
-            board_move(cb, node);
-            value = min_max(cb, searchDepth, INT_MIN, INT_MAX, PS_UP);
-            board_undo(cb);
-
-            if (value >= maxValue){
-                maxValue = value;
-                memcpy(bestMove, node, sizeof(struct MoveNode));
-            }
-        }
-
-        free(possibleMoves);
-    }
-    else {
-        memset(bestMove, 0, sizeof(struct MoveNode));
-    }
-}
-
-/*
-    get a user input line.
-    if the length of the user input exceed the given param len,
-    then the exceed parts will be ignored, like this:
-
-    limits: 5
-
-    abcdefg
-    abcd
-*/
-static int get_line(char* buf, size_t len){
-	assert(buf != NULL && len != 0);
-	
-    int count = 0;
-    char c;
-
-    while(1) {
-        c = getchar();
-        if(c == '\n' || c == EOF){
-            break;
-        }
-
-        if (count < len - 1){
-            buf[count] = c;
-            ++count;
-        }
-    }
-
-    buf[count] = '\0';
-    return count;
-}
-
-/* given move is fit for rule ? return 0 if not. */
-static int check_rule(struct ChessBoard* cb, const struct MoveNode* moveNode){
-    assert(cb != NULL && moveNode != NULL);
-
-    int valid = 0;
-    enum Piece p = cb->data[moveNode->beginRow][moveNode->beginCol];
-    struct PossibleMoves* pm = board_gen_possible_moves(cb, piece_get_side[p]);
-
-    int i;
-    struct MoveNode* cursor;
-    for (i = 0;i < pm->len;++i){
-        cursor = &(pm->data[i]);
-
-        if (memcmp(cursor, moveNode, sizeof(struct MoveNode)) == 0){
-            valid = 1;
-            break;
-        }
-    }
-
-    free(pm);
-    return valid;
-}
-
-/* user input could represent a move ? return 0 if can't. */
-static int check_input_is_a_move(char* input, size_t len){
-    assert(input == NULL);
-
-    if (len < 4){
-        return 0;
-    }
-
-    return  (input[0] >= 'a' && input[0] <= 'i') &&
-            (input[1] >= '0' && input[1] <= '9') &&
-            (input[2] >= 'a' && input[2] <= 'i') &&
-            (input[3] >= '0' && input[3] <= '9');
-}
-
-/*
-    convert user input to a struct MoveNode object.
-    you should call check_input_is_a_move() before to make sure this converting is valid.
-*/
-static void convert_input_to_move(char* input, struct MoveNode* move){
-    assert(input != NULL && move != NULL);
-
-    move->beginRow = 9 - ((int)input[1] - (int)'0') + BOARD_ACTUAL_ROW_BEGIN;
-    move->beginCol = (int)input[0] - (int)'a' + BOARD_ACTUAL_COL_BEGIN;
-    move->endRow = 9 - ((int)input[3] - (int)'0') + BOARD_ACTUAL_ROW_BEGIN;
-    move->endCol = (int)input[2] - (int)'a' + BOARD_ACTUAL_COL_BEGIN;
-}
-
-/* 
-    convert a move to string. 
-    len must be bigger or equal to MOVE_TO_STR_BUFFER_LEN, otherwise this function returns 0.
-*/
-static int convert_move_to_str(const struct MoveNode* move, char* buf, size_t len){
-    assert(move != NULL && buf != NULL);
-
-    if (len < MOVE_TO_STR_BUFFER_LEN){
-        return 0;
-    }
-
-    buf[0] = move->beginCol - BOARD_ACTUAL_COL_BEGIN + 'a';
-    buf[1] = 9 - (move->beginRow - BOARD_ACTUAL_ROW_BEGIN) + '0';
-    buf[2] = move->endCol - BOARD_ACTUAL_COL_BEGIN + 'a';
-    buf[3] = 9 - (move->endRow - BOARD_ACTUAL_ROW_BEGIN) + '0';
-    buf[4] = '\0';
-    return 1;
-}
-
-/* every one can only move his pieces, not the enemy's. */
-static int check_is_this_your_piece(const struct ChessBoard* cb, const struct MoveNode* move, enum PieceSide side){
-    enum Piece p = cb->data[move->beginRow][move->beginCol];
-    return piece_get_side[p] == side;
-}
-
-/* if no one wins, return PS_EXTRA. */
-static enum PieceSide check_winner(const struct ChessBoard* cb){
-    assert(cb != NULL);
-
-    int upAlive = 0;
-    int downAlive = 0;
-
-    int r, c;
-    for (r = BOARD_9_PALACE_UP_TOP; r <= BOARD_9_PALACE_UP_BOTTOM; ++r) {
-        for (c = BOARD_9_PALACE_UP_LEFT; c <= BOARD_9_PALACE_UP_RIGHT; ++c) {
-            if (cb->data[r][c] == P_UG) {
-                upAlive = 1;
-                break;
-            }
-        }
-    }
-
-    for (r = BOARD_9_PALACE_DOWN_TOP; r <= BOARD_9_PALACE_DOWN_BOTTOM; ++r) {
-        for (c = BOARD_9_PALACE_DOWN_LEFT; c <= BOARD_9_PALACE_DOWN_RIGHT; ++c) {
-            if (cb->data[r][c] == P_DG) {
-                downAlive = 1;
-                break;
-            }
-        }
-    }
-
-    if (upAlive && downAlive) {
-        return PS_EXTRA;
-    }
-    else if (upAlive) {
-        return PS_UP;
-    }
-    else {
-        return PS_DOWN;
-    }
-}
-
-static void print_help_page(void){
-    printf("\n=======================================\n");
-    printf("Help Page\n\n");
-    printf("    1. help         - this page.\n");
-    printf("    2. b2e2         - input like this will be parsed as a move.\n");
-    printf("    3. undo         - undo the previous move.\n");
-    printf("    4. exit or quit - exit the game.\n");
-    printf("    5. remake       - remake the game.\n");
-    printf("    6. advice       - give me a best move.\n\n");
-    printf("  The characters on the board have the following relationships: \n\n");
-    printf("    P -> AI side pawn.\n");
-    printf("    C -> AI side cannon.\n");
-    printf("    R -> AI side rook.\n");
-    printf("    N -> AI side knight.\n");
-    printf("    B -> AI side bishop.\n");
-    printf("    A -> AI side advisor.\n");
-    printf("    G -> AI side general.\n");
-    printf("    p -> our pawn.\n");
-    printf("    c -> our cannon.\n");
-    printf("    r -> our rook.\n");
-    printf("    n -> our knight.\n");
-    printf("    b -> our bishop.\n");
-    printf("    a -> our advisor.\n");
-    printf("    g -> our general.\n");
-    printf("    . -> no piece here.\n");
-    printf("=======================================\n");
-    printf("Press any key to continue.\n");
-
-    (void)getchar();
-}
-
-#define CNCHESS_AI_SEARCH_DEPTH 4
-#define USER_SIDE  PS_DOWN
-#define AI_SIDE    PS_UP
-
-int main(){
-    struct ChessBoard* cb = board_make_new();
-    char userInput[MAX_USER_INPUT_BUFFER_LEN];
-    char moveStr[MOVE_TO_STR_BUFFER_LEN];
-    struct MoveNode userMove, aiMove, userAdviceMove;
-
-    board_print_to_console(cb);
-
-    while (1){
-        printf("Your move: ");
-        get_line(userInput, MAX_HISOTRY_BUF_LEN);
-
-        if (strcmp(userInput, "help") == 0){
-            print_help_page();
-            board_print_to_console(cb);
-        }
-        else if (strcmp(userInput, "undo") == 0){
-            board_undo(cb);
-            board_undo(cb);
-            board_print_to_console(cb);
-        }
-        else if (strcmp(userInput, "quit") == 0){
-            goto EXIT_CNCHESS;
-        }
-        else if (strcmp(userInput, "exit") == 0){
-            goto EXIT_CNCHESS;
-        }
-        else if (strcmp(userInput, "remake") == 0){
-            free(cb);
-            cb = board_make_new();
-
-            printf("New cnchess started.\n");
-            board_print_to_console(cb);
-            continue;
-        }
-        else if (strcmp(userInput, "advice") == 0){
-            board_gen_best_move(cb, USER_SIDE, CNCHESS_AI_SEARCH_DEPTH, &userAdviceMove);
-            convert_move_to_str(&userAdviceMove, moveStr, MOVE_TO_STR_BUFFER_LEN);
-            printf("Maybe you can try: %s, piece is %c.\n", moveStr, piece_get_char[cb->data[userAdviceMove.beginRow][userAdviceMove.beginCol]]);
-        }
-        else{
-            if (check_input_is_a_move(userInput, strlen(userInput))){
-                convert_input_to_move(userInput, &userMove);
-                
-                if (!check_is_this_your_piece(cb, &userMove, USER_SIDE)){
-                    printf("This piece is not yours, please choose your piece.\n");
-                    continue;
-                }
-
-                if (check_rule(cb, &userMove)){
-                    board_move(cb, &userMove);
-                    board_print_to_console(cb);
-
-                    if (check_winner(cb) == USER_SIDE){
-                        printf("Congratulations! You win!\n");
-                        goto EXIT_CNCHESS;
-                    }
-
-                    printf("AI thinking...\n");
-                    board_gen_best_move(cb, AI_SIDE, CNCHESS_AI_SEARCH_DEPTH, &aiMove);
-                    convert_move_to_str(&aiMove, moveStr, MOVE_TO_STR_BUFFER_LEN);
-                    board_move(cb, &aiMove);
-                    board_print_to_console(cb);
-                    printf("AI move: %s, piece is '%c'.\n", moveStr, piece_get_char[cb->data[aiMove.endRow][aiMove.endCol]]);
-
-                    if (check_winner(cb) == AI_SIDE){
-                        printf("Game over! You lose!\n");
-                        goto EXIT_CNCHESS;
-                    }
-                }
-                else {
-                    printf("Given move does't fit for rules, please re-enter.\n");
-                    continue;
-                }
-            }
-            else {
-                printf("Input is not a valid move nor instruction, please re-enter(try help ?).\n");
-                continue;
-            }
-        }
-    }
-
-EXIT_CNCHESS:
-    free(cb);
-    return 0;
-}
+#define NDEBUG
+#define _POSIX_C_SOURCE 200809L
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#include <assert.h>
+#include <limits.h>
+#include <errno.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/file.h>
+#include <pthread.h>
+
+#include "cnchess.h"
+
+/*
+	Chinese chess board is 10 x 9,
+	to speed up rules checking, I added 2 lines for both the top, left, bottom and right sides.
+*/
+#define BOARD_ROW_LEN 14
+#define BOARD_COL_LEN 13
+#define BOARD_ACTUAL_ROW_LEN 10
+#define BOARD_ACTUAL_COL_LEN 9
+#define BOARD_ACTUAL_ROW_BEGIN 2
+#define BOARD_ACTUAL_COL_BEGIN 2
+
+/* the board is symmetric about the e-file, this is the column c is mirrored to. */
+#define BOARD_MIRROR_COL(c) (2 * BOARD_ACTUAL_COL_BEGIN + BOARD_ACTUAL_COL_LEN - 1 - (c))
+
+/* if a pawn has crossed the faced river, then he can move forward, left or right. */
+#define BOARD_RIVER_UP    (BOARD_ACTUAL_ROW_BEGIN + 4)
+#define BOARD_RIVER_DOWN  (BOARD_ACTUAL_ROW_BEGIN + 5)
+
+/* piece: general and advisor must stay within the 9 palace. */
+#define BOARD_9_PALACE_UP_TOP     (BOARD_ACTUAL_ROW_BEGIN)
+#define BOARD_9_PALACE_UP_BOTTOM  (BOARD_ACTUAL_ROW_BEGIN + 2)
+#define BOARD_9_PALACE_UP_LEFT    (BOARD_ACTUAL_COL_BEGIN + 3)
+#define BOARD_9_PALACE_UP_RIGHT   (BOARD_ACTUAL_COL_BEGIN + 5)
+
+#define BOARD_9_PALACE_DOWN_TOP     (BOARD_ACTUAL_ROW_BEGIN + 7)
+#define BOARD_9_PALACE_DOWN_BOTTOM  (BOARD_ACTUAL_ROW_BEGIN + 9)
+#define BOARD_9_PALACE_DOWN_LEFT    (BOARD_ACTUAL_COL_BEGIN + 3)
+#define BOARD_9_PALACE_DOWN_RIGHT   (BOARD_ACTUAL_COL_BEGIN + 5)
+
+/* 1024 means 512 rounds, I think this is big enough for one game, a longer game is considered as a draw. */
+#define MAX_HISOTRY_BUF_LEN 1024
+
+/* the initial capacity of a game record, it grows when full. */
+#define GAME_RECORD_INIT_CAPACITY 64
+
+/* the max search depth in plies, the search-local undo stack is sized by this. */
+#define MAX_SEARCH_PLY 64
+
+/* score of a side who loses the game by perpetual check or perpetual chase, as bad as losing the general. */
+#define SCORE_RULE_LOSS 10000
+
+/* bigger than any score, the search window starts at [-SCORE_INFINITE, SCORE_INFINITE]. */
+#define SCORE_INFINITE 1000000
+
+/* The max number of steps a player can take in a single turn. */
+#define MAX_ONE_SIDE_POSSIBLE_MOVES_LEN 256
+
+/* which kind of moves the generators produce, quiet moves go to empty squares, captures take an enemy piece. */
+#define GEN_QUIET    1
+#define GEN_CAPTURE  2
+#define GEN_ALL      (GEN_QUIET | GEN_CAPTURE)
+
+/* user input string length limitation. */
+#define MAX_USER_INPUT_BUFFER_LEN 8
+
+/* the length of buffer for converting a move to string. */
+#define MOVE_TO_STR_BUFFER_LEN 5
+
+/* compare max and min macros, never use function as parameter, otherwise the function will be called twice. */
+#define COMPARE_MAX(left, right) ((left) > (right) ? (left) : (right))
+#define COMPARE_MIN(left, right) ((left) < (right) ? (left) : (right))
+
+/* 
+    a function always inlined, the move generators and the search are written once with a side parameter,
+    and every caller passes a constant side, so the compiler builds one copy for each side with no test of the side left.
+*/
+#define FORCE_INLINE static inline __attribute__((always_inline))
+
+/* the other side, and the sign turning a score of the board (down is positive) into the view of side. */
+#define SIDE_REVERSE(side) ((side) == PS_UP ? PS_DOWN : PS_UP)
+#define SIDE_SIGN(side) ((side) == PS_UP ? -1 : +1)
+
+/* the instance of fn built for side, or for its enemy: fn_up or fn_down. */
+#define SIDE_INSTANCE(fn, side) ((side) == PS_UP ? fn##_up : fn##_down)
+#define SIDE_OTHER_INSTANCE(fn, side) ((side) == PS_UP ? fn##_down : fn##_up)
+
+/* piece side. */
+enum PieceSide{
+    PS_UP,         /* upper side player. */
+    PS_DOWN,       /* down side player. */
+    PS_EXTRA       /* neither upper nor down, for example: empty or out of chess board. */
+};
+
+/* piece type. */
+enum PieceType{
+    PT_PAWN,       /* pawn. */
+    PT_CANNON,     /* cannon. */
+    PT_ROOK,       /* rook. */
+    PT_KNIGHT,     /* knight. */
+    PT_BISHOP,     /* bishop. */
+    PT_ADVISOR,    /* advisor. */
+    PT_GENERAL,    /* general. */
+    PT_EMPTY,      /* empty here. */
+    PT_OUT         /* out of chess board. */
+};
+
+/* piece. */
+enum Piece{
+    P_UP,              /* upper pawn. */
+    P_UC,              /* upper cannon. */
+    P_UR,              /* upper rook. */
+    P_UN,              /* upper knight. */
+    P_UB,              /* upper bishop. */
+    P_UA,              /* upper advisor. */
+    P_UG,              /* upper general. */
+    P_DP,              /* down pawn. */
+    P_DC,              /* down cannon. */
+    P_DR,              /* down rook. */
+    P_DN,              /* down knight. */
+    P_DB,              /* down bishop. */
+    P_DA,              /* down advisor. */
+    P_DG,              /* down general. */
+    P_EE,              /* empty. */
+    P_EO,              /* out of chess board. used for speeding up rules checking. */
+    PIECE_TOTAL_LEN    /* total number of pieces, you maybe never need this. */
+};
+
+static const char piece_get_char[] = {
+    /* cause #include<> just copy the content, so why not write those things to a txt file rather than writing in code ? */
+    #include "chessBoardPieceChar.txt"
+};
+
+static const enum PieceSide piece_get_side[] = {
+    PS_UP, PS_UP, PS_UP, PS_UP, PS_UP, PS_UP, PS_UP,
+    PS_DOWN, PS_DOWN, PS_DOWN, PS_DOWN, PS_DOWN, PS_DOWN, PS_DOWN,
+    PS_EXTRA, PS_EXTRA
+};
+
+static const enum PieceType piece_get_type[] = {
+    PT_PAWN, PT_CANNON, PT_ROOK, PT_KNIGHT, PT_BISHOP, PT_ADVISOR, PT_GENERAL,
+    PT_PAWN, PT_CANNON, PT_ROOK, PT_KNIGHT, PT_BISHOP, PT_ADVISOR, PT_GENERAL,
+    PT_EMPTY, PT_OUT
+};
+
+static const enum PieceSide piece_side_get_reverse_side[] = {
+    PS_DOWN,     /* upper side reverse is down. */
+    PS_UP,       /* down side reverse is up. */
+    PS_EXTRA     /* extra remains extra. */
+};
+
+/*
+	every piece's value. 
+	upper side piece's value is negative, down side is positive. 
+*/
+static const int piece_get_value[] = {
+    #include "chessBoardPieceValue.txt"
+};
+
+/* 
+	every piece's position value on the chess board. 
+	upper side piece's value is negative, down side is positive. 
+*/
+static const int piece_get_pos_value[][BOARD_ACTUAL_ROW_LEN][BOARD_ACTUAL_COL_LEN] = {
+    #include "chessBoardPosValue.txt"
+};
+
+/* 
+    a default chess board, used as a template for new board.
+    P_EO is used here for speeding up rules checking.
+*/
+static const enum Piece CHESS_BOARD_DEFAULT_TEMPLATE[BOARD_ROW_LEN][BOARD_COL_LEN] = {
+    { P_EO, P_EO, P_EO, P_EO, P_EO, P_EO, P_EO, P_EO, P_EO, P_EO, P_EO, P_EO, P_EO },
+    { P_EO, P_EO, P_EO, P_EO, P_EO, P_EO, P_EO, P_EO, P_EO, P_EO, P_EO, P_EO, P_EO },
+    { P_EO, P_EO, P_UR, P_UN, P_UB, P_UA, P_UG, P_UA, P_UB, P_UN, P_UR, P_EO, P_EO },
+    { P_EO, P_EO, P_EE, P_EE, P_EE, P_EE, P_EE, P_EE, P_EE, P_EE, P_EE, P_EO, P_EO },
+    { P_EO, P_EO, P_EE, P_UC, P_EE, P_EE, P_EE, P_EE, P_EE, P_UC, P_EE, P_EO, P_EO },
+    { P_EO, P_EO, P_UP, P_EE, P_UP, P_EE, P_UP, P_EE, P_UP, P_EE, P_UP, P_EO, P_EO },
+    { P_EO, P_EO, P_EE, P_EE, P_EE, P_EE, P_EE, P_EE, P_EE, P_EE, P_EE, P_EO, P_EO },
+    { P_EO, P_EO, P_EE, P_EE, P_EE, P_EE, P_EE, P_EE, P_EE, P_EE, P_EE, P_EO, P_EO },
+    { P_EO, P_EO, P_DP, P_EE, P_DP, P_EE, P_DP, P_EE, P_DP, P_EE, P_DP, P_EO, P_EO },
+    { P_EO, P_EO, P_EE, P_DC, P_EE, P_EE, P_EE, P_EE, P_EE, P_DC, P_EE, P_EO, P_EO },
+    { P_EO, P_EO, P_EE, P_EE, P_EE, P_EE, P_EE, P_EE, P_EE, P_EE, P_EE, P_EO, P_EO },
+    { P_EO, P_EO, P_DR, P_DN, P_DB, P_DA, P_DG, P_DA, P_DB, P_DN, P_DR, P_EO, P_EO },
+    { P_EO, P_EO, P_EO, P_EO, P_EO, P_EO, P_EO, P_EO, P_EO, P_EO, P_EO, P_EO, P_EO },
+    { P_EO, P_EO, P_EO, P_EO, P_EO, P_EO, P_EO, P_EO, P_EO, P_EO, P_EO, P_EO, P_EO },
+};
+
+/* move node, reprensent a move. */
+struct MoveNode{
+    int beginRow;
+    int beginCol;
+    int endRow;
+    int endCol;
+};
+
+/* history node, used for undo the previous move. */
+struct HistoryNode{
+    struct MoveNode move;
+    enum Piece beginPiece;
+    enum Piece endPiece;
+    unsigned long long hash;          /* board hash before this move. */
+    unsigned long long mirrorHash;    /* board mirror hash before this move. */
+    long score;                       /* board score before this move. */
+};
+
+/* 
+    chess board, only the position itself, so it is cheap to copy.
+    the moves played are kept by struct GameRecord or struct SearchContext.
+*/
+struct ChessBoard{
+    enum Piece data[BOARD_ROW_LEN][BOARD_COL_LEN];
+    unsigned long long hash;          /* zobrist hash, updated incrementally. */
+    unsigned long long mirrorHash;    /* zobrist hash of the board mirrored left to right, updated incrementally. */
+    long score;                       /* same as board_calc_score(), updated incrementally. */
+    enum PieceSide side;              /* side to move. */
+};
+
+/* game record, a growable history of the moves played in one game. */
+struct GameRecord{
+    struct HistoryNode* history;
+    size_t length;
+    size_t capacity;
+};
+
+/* a game: the current board and how we got there. */
+struct Game{
+    struct ChessBoard board;
+    struct GameRecord record;
+};
+
+/* result of playing a move in a game. */
+enum GameStatus{
+    GS_ONGOING,       /* nothing special, game goes on. */
+    GS_DRAW_TOO_LONG, /* the game has exceeded MAX_HISOTRY_BUF_LEN moves, it is a draw and the move is not played. */
+    GS_OUT_OF_MEMORY  /* the record could not grow, the move is not played. */
+};
+
+/* what kind of score a transposition table entry holds. */
+enum TransBound{
+    TB_NONE,     /* empty entry. */
+    TB_EXACT,    /* the exact score. */
+    TB_LOWER,    /* the real score is bigger or equal. */
+    TB_UPPER     /* the real score is smaller or equal. */
+};
+
+/* transposition table entry, remembers the result of searching one position. */
+struct TransEntry{
+    unsigned long long hash;
+    struct MoveNode move;     /* best move found, tried first when we meet this position again. */
+    int score;                /* from the view of the side to move. */
+    unsigned char depth;
+    unsigned char bound;      /* enum TransBound. */
+};
+
+/* 
+    a transposition table entry as stored, 16 bytes. data packs the entry, see trans_table_pack(), check is hash ^ data.
+    the table may be written by other threads or processes at the same time without any lock,
+    an entry torn by two writers does not pass the check and is taken as empty.
+*/
+struct TransSlot{
+    unsigned long long check;
+    unsigned long long data;
+};
+
+/* transposition table, the number of slots is a power of 2. */
+struct TransTable{
+    struct TransSlot* slots;
+    size_t mask;
+    void* mapping;            /* the whole memory mapping, shared tables start with a struct TransSharedHeader. */
+    size_t mappingSize;
+    int shared;               /* in a POSIX shared memory segment, used by other processes too. */
+};
+
+/* the start of a shared transposition table segment, the processes attaching it check the layout. */
+#define TRANS_SHARED_MAGIC "CNCHTT2"
+
+struct TransSharedHeader{
+    char magic[8];
+    unsigned long long count;    /* number of slots. */
+    char reserved[48];           /* keeps the slots 64 bytes aligned. */
+};
+
+/* opening book entry, the move is seen on the board with the smaller hash, like mirrored transposition table entries. */
+struct BookEntry{
+    unsigned long long key;    /* board_canonical_hash() of the position. */
+    struct MoveNode move;
+    unsigned int count;        /* how many book lines play this move here. */
+};
+
+/* search statistics. */
+struct SearchStats{
+    unsigned long long nodes;             /* negamax and quiescence calls. */
+    unsigned long long generatedMoves;    /* moves produced by the generators. */
+    unsigned int depth;                   /* the deepest iteration completed. */
+    unsigned long long ttProbes;          /* transposition table lookups. */
+    unsigned long long ttHits;            /* lookups that found the position. */
+    unsigned long long evals;             /* static evaluations. */
+    unsigned long long evalLazy;          /* evaluations far outside the window, the positional terms are skipped. */
+    unsigned long long evalCacheProbes;   /* the other evaluations look up the evaluation cache. */
+    unsigned long long evalCacheHits;
+    long long evalTimeNs;                 /* time calculating positional terms, estimated from a sample, see EVAL_TIME_SAMPLE. */
+};
+
+/* result of a finished game, as stored in game record files. */
+enum RecordResult{
+    RR_UNKNOWN,    /* "*", the game was not finished. */
+    RR_DOWN_WIN,   /* "1-0", down side moves first. */
+    RR_UP_WIN,     /* "0-1". */
+    RR_DRAW        /* "1/2-1/2". */
+};
+
+/* 
+    streaming game record writer, games are appended one by one and flushed at once.
+    text format: one game per line, ICCS moves like "h2e2" split by spaces, then the result.
+    empty lines are not games, so the game numbers of a text record count the non-empty lines only.
+    binary format: the header "CNCR" and a version byte, then for every game a 2 bytes move count,
+    a result byte, and 2 bytes for every move: begin square | (end square << 7), squares are 0 - 89, little endian.
+*/
+struct RecordWriter{
+    FILE* fp;
+    int binary;
+};
+
+/* 
+    game record reader, the whole file is memory mapped, the format is detected by the header.
+    moves are ICCS "h2e2" or "H2-E2" in text files.
+*/
+struct RecordReader{
+    const unsigned char* data;
+    size_t size;
+    size_t pos;
+    int binary;
+};
+
+/* the deepest remaining depth futility pruning and razoring work at. */
+#define SEARCH_FUTILITY_MAX_DEPTH 2
+#define SEARCH_RAZOR_MAX_DEPTH 3
+
+/* tunable search parameters, margins are indexed by the remaining depth, a negative margin turns that depth off. */
+struct SearchParams{
+    int futilityMargin[SEARCH_FUTILITY_MAX_DEPTH + 1];    /* depth 1 - 2. */
+    int razorMargin[SEARCH_RAZOR_MAX_DEPTH + 1];          /* depth 2 - 3. */
+};
+
+/* a game clock of the side to move, in milliseconds. */
+struct TimeControl{
+    long long remainingMs;      /* main time left. */
+    long long incrementMs;      /* added after every move. */
+    unsigned int movesToGo;     /* moves to the next time control, 0 means the main time is for the rest of the game. */
+    long long byoyomiMs;        /* every move may use this much once the main time has run out. */
+    long long overheadMs;       /* kept back for I/O and scheduling latency. */
+};
+
+/* 
+    time budget of one search. the search is aborted at the hard limit, and no new iteration is started
+    once most of the soft limit is used. the soft limit grows while the best move changes or the score drops.
+*/
+struct TimeManager{
+    int active;
+    long long start;            /* time_now_ms() value. */
+    long long softMs;
+    long long hardMs;
+    int scale;                  /* percent of softMs we may use. */
+    struct MoveNode lastMove;   /* the best move and score of the last iteration. */
+    int lastValue;
+    unsigned int stable;        /* iterations in a row the best move has not changed. */
+};
+
+/* one root move of a Multi-PV search: its principal variation, the move first, and its score. */
+struct SearchLine{
+    struct MoveNode moves[MAX_SEARCH_PLY];
+    int len;
+    int value;
+};
+
+/* 
+    the evaluation cache, direct mapped by the low bits of the board hash, kept between searches like the transposition table.
+    an entry keeps the high 48 bits of the hash and the 16 bits positional score, 0 is empty.
+    an entry is one word, the searches of many threads share a cache without locks.
+*/
+#define EVAL_CACHE_BITS 13
+#define EVAL_CACHE_SIZE (1 << EVAL_CACHE_BITS)
+#define EVAL_CACHE_SCORE_MASK 0xFFFFULL
+
+struct EvalCache{
+    unsigned long long entries[EVAL_CACHE_SIZE];
+};
+
+/* only one in this many positional evaluations is timed, reading the clock every time would cost a tenth of the evaluation. a power of 2. */
+#define EVAL_TIME_SAMPLE 64
+
+/*
+    how many times a line of the quiescence search may answer a check with every move, instead of standing pat.
+    checks answered by checks would otherwise take the capture-only search as deep as a full one.
+*/
+#define QUIESCENCE_MAX_EVASIONS 1
+
+/* search-local state, the search works on its own copy of the board and never touches the game record. */
+struct SearchContext{
+    struct ChessBoard board;
+    struct HistoryNode undo[MAX_SEARCH_PLY];
+    int ply;
+    const struct GameRecord* record;    /* moves played before the search, for repetition detection, may be NULL. */
+    struct TransTable* tt;              /* may be NULL. */
+    struct MoveNode killers[MAX_SEARCH_PLY][2];    /* quiet moves that caused a cutoff at the same ply. */
+    struct MoveNode pv[MAX_SEARCH_PLY][MAX_SEARCH_PLY];    /* principal variation found below every ply. */
+    int pvLen[MAX_SEARCH_PLY];
+    struct MoveNode bestLine[MAX_SEARCH_PLY];      /* principal variation of the last completed iteration. */
+    int bestLineLen;
+    struct SearchStats stats;
+    const struct SearchParams* params;
+
+    /* search limits, 0 or NULL means no limit. once one is hit, aborted is set and the search unwinds. */
+    unsigned long long nodeLimit;
+    long long deadline;                 /* time_now_ms() value. */
+    const volatile int* stop;           /* the search stops soon after *stop becomes non zero. */
+    int aborted;
+    struct TimeManager timer;           /* when active, ends the iterative deepening early. */
+    struct EvalCache* evalCache;        /* may be NULL. */
+    unsigned long long repetitions;     /* repeated positions met, a score below one depends on the moves played before it. */
+    int evasions;                       /* quiescence nodes in check on the current line, see QUIESCENCE_MAX_EVASIONS. */
+};
+
+/* 
+    the transposition table shares entries between a board and its left-right mirror up to this ply.
+    the evaluation is symmetric, so both have the same score.
+*/
+#define SEARCH_MIRROR_MAX_PLY 4
+
+/* how often (in nodes, minus 1) the clock and the stop flag are polled. */
+#define SEARCH_POLL_MASK 1023
+
+/* 
+    time manager tuning. without moves to go, the main time is spread over this many moves.
+    the hard limit is a few times the soft one, and no iteration starts after this percent of the soft limit,
+    the next one would not finish in time.
+*/
+#define TIME_DEFAULT_MOVES_TO_GO 30
+#define TIME_HARD_FACTOR 5
+#define TIME_NEXT_ITERATION_PERCENT 60
+
+/* the soft limit grows by these percents when the best move changes or the score drops by TIME_SCORE_DROP, up to TIME_MAX_SCALE. */
+#define TIME_MOVE_CHANGE_PERCENT 40
+#define TIME_SCORE_DROP_PERCENT 40
+#define TIME_SCORE_DROP 15
+#define TIME_MAX_SCALE 250
+
+/* 
+    a root move dominates when every other one, searched TIME_DOMINANCE_REDUCTION plies shallower, is worse by TIME_DOMINANCE_MARGIN.
+    it is checked once the best move has been stable for TIME_DOMINANCE_STABLE iterations, and the search stops then.
+*/
+#define TIME_DOMINANCE_MARGIN 40
+#define TIME_DOMINANCE_REDUCTION 3
+#define TIME_DOMINANCE_MIN_DEPTH 5
+#define TIME_DOMINANCE_STABLE 2
+
+/* the max number of targets a short-range piece (knight, bishop, advisor, general, pawn) has from one square. */
+#define MAX_STEP_TARGETS 8
+
+/* one target of a short-range piece, blockRow and blockCol are the lame horse leg or the Xiang Yan, if the piece has one. */
+struct StepTarget{
+    unsigned char row;
+    unsigned char col;
+    unsigned char blockRow;
+    unsigned char blockCol;
+};
+
+/* all targets of a short-range piece from one square, palace, river and board bounds have been checked. */
+struct StepTable{
+    struct StepTarget targets[MAX_STEP_TARGETS];
+    int len;
+};
+
+/* possible moves. */
+struct PossibleMoves{
+    struct MoveNode data[MAX_ONE_SIDE_POSSIBLE_MOVES_LEN];
+    size_t len;
+};
+
+/* stages of struct MovePicker, in the order they are walked. */
+enum PickStage{
+    PICK_HASH,            /* the move stored in the transposition table, nothing generated yet. */
+    PICK_GEN_CAPTURES,
+    PICK_CAPTURES,        /* most valuable victim first, least valuable attacker first, losing captures are put off. */
+    PICK_KILLERS,
+    PICK_GEN_QUIETS,
+    PICK_QUIETS,
+    PICK_BAD_CAPTURES,    /* captures that lose material by static exchange evaluation. */
+    PICK_DONE
+};
+
+/* 
+    staged, lazy move generation: moves are only generated when the previous stage did not cause a cutoff.
+    every move is yielded at most once.
+*/
+struct MovePicker{
+    enum PickStage stage;
+    struct MoveNode hashMove;
+    int hasHashMove;
+    struct PossibleMoves moves;
+    int scores[MAX_ONE_SIDE_POSSIBLE_MOVES_LEN];
+    size_t index;
+    size_t badCount;      /* losing captures are kept at the front of moves, the slots already walked. */
+    int capturesOnly;     /* for quiescence search: no quiet moves, and losing captures are pruned. */
+};
+
+/* monotonic clock in milliseconds, only differences are meaningful. */
+static long long time_now_ms(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+/* the same clock in nanoseconds. */
+static long long time_now_ns(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+/* 
+    zobrist keys for every piece on every square, empty and out of board pieces have key 0.
+    filled once by tables_init(), read only after that.
+*/
+static unsigned long long zobrist_piece[PIECE_TOTAL_LEN][BOARD_ROW_LEN][BOARD_COL_LEN];
+static unsigned long long zobrist_side;
+
+/* piece value plus position value for every piece on every square, 0 for empty and out of board pieces. */
+static long piece_square_value[PIECE_TOTAL_LEN][BOARD_ROW_LEN][BOARD_COL_LEN];
+
+/* 
+    targets of the short-range pieces for every square, indexed by side too if the rules depend on it.
+    filled once by tables_init(), read only after that.
+*/
+static struct StepTable knight_steps[BOARD_ROW_LEN][BOARD_COL_LEN];
+static struct StepTable bishop_steps[2][BOARD_ROW_LEN][BOARD_COL_LEN];
+static struct StepTable advisor_steps[2][BOARD_ROW_LEN][BOARD_COL_LEN];
+static struct StepTable general_steps[2][BOARD_ROW_LEN][BOARD_COL_LEN];
+static struct StepTable pawn_steps[2][BOARD_ROW_LEN][BOARD_COL_LEN];
+
+/* the max number of different moves in the opening book. */
+#define OPENING_BOOK_MAX_ENTRIES 512
+
+/* opening book sorted by key, filled once by tables_init(), read only after that. */
+static struct BookEntry opening_book[OPENING_BOOK_MAX_ENTRIES];
+static size_t opening_book_len;
+
+/* splitmix64, a small pseudo random generator, a fixed seed keeps hashes the same between runs. */
+static unsigned long long random_next(unsigned long long* state){
+    unsigned long long z = (*state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+static int board_in_palace(int r, int c, enum PieceSide side);
+
+static int board_in_actual(int r, int c){
+    return r >= BOARD_ACTUAL_ROW_BEGIN && r < BOARD_ACTUAL_ROW_BEGIN + BOARD_ACTUAL_ROW_LEN && 
+           c >= BOARD_ACTUAL_COL_BEGIN && c < BOARD_ACTUAL_COL_BEGIN + BOARD_ACTUAL_COL_LEN;
+}
+
+static void step_table_insert(struct StepTable* st, int row, int col, int blockRow, int blockCol){
+    assert(st != NULL && st->len < MAX_STEP_TARGETS);
+
+    struct StepTarget* target = &(st->targets[st->len]);
+    target->row = (unsigned char)row;
+    target->col = (unsigned char)col;
+    target->blockRow = (unsigned char)blockRow;
+    target->blockCol = (unsigned char)blockCol;
+    ++(st->len);
+}
+
+/* fill the step tables with the same rules the generators used to check at every call. */
+static void step_tables_init(void){
+    static const int lineGap[4][2] = { { +1, 0 }, { -1, 0 }, { 0, +1 }, { 0, -1 } };
+    static const int diagonalGap[4][2] = { { +1, +1 }, { +1, -1 }, { -1, +1 }, { -1, -1 } };
+    static const int knightGap[8][4] = {    /* row gap, col gap, then the leg. */
+        { +2, +1, +1, 0 }, { +2, -1, +1, 0 }, { -2, +1, -1, 0 }, { -2, -1, -1, 0 },
+        { +1, +2, 0, +1 }, { -1, +2, 0, +1 }, { +1, -2, 0, -1 }, { -1, -2, 0, -1 }
+    };
+    int side, r, c, i;
+
+    /* start from empty tables, the inserts below append. */
+    memset(knight_steps, 0, sizeof(knight_steps));
+    memset(bishop_steps, 0, sizeof(bishop_steps));
+    memset(advisor_steps, 0, sizeof(advisor_steps));
+    memset(general_steps, 0, sizeof(general_steps));
+    memset(pawn_steps, 0, sizeof(pawn_steps));
+
+    for (r = BOARD_ACTUAL_ROW_BEGIN; r < BOARD_ACTUAL_ROW_BEGIN + BOARD_ACTUAL_ROW_LEN; ++r){
+        for (c = BOARD_ACTUAL_COL_BEGIN; c < BOARD_ACTUAL_COL_BEGIN + BOARD_ACTUAL_COL_LEN; ++c){
+            /* knight, the leg is next to the knight on the long side of the move. */
+            for (i = 0; i < 8; ++i){
+                if (board_in_actual(r + knightGap[i][0], c + knightGap[i][1])){
+                    step_table_insert(&(knight_steps[r][c]), r + knightGap[i][0], c + knightGap[i][1], r + knightGap[i][2], c + knightGap[i][3]);
+                }
+            }
+
+            for (side = PS_UP; side <= PS_DOWN; ++side){
+                /* bishop can't cross river, and moves only if Xiang Yan is empty. */
+                for (i = 0; i < 4; ++i){
+                    int row = r + 2 * diagonalGap[i][0], col = c + 2 * diagonalGap[i][1];
+
+                    if (board_in_actual(row, col) && ((side == PS_UP) ? (row <= BOARD_RIVER_UP) : (row >= BOARD_RIVER_DOWN))){
+                        step_table_insert(&(bishop_steps[side][r][c]), row, col, r + diagonalGap[i][0], c + diagonalGap[i][1]);
+                    }
+                }
+
+                /* advisor walks diagonal lines, general walks horizontal or vertical, both within the 9 palace. */
+                for (i = 0; i < 4; ++i){
+                    if (board_in_palace(r + diagonalGap[i][0], c + diagonalGap[i][1], side)){
+                        step_table_insert(&(advisor_steps[side][r][c]), r + diagonalGap[i][0], c + diagonalGap[i][1], r, c);
+                    }
+
+                    if (board_in_palace(r + lineGap[i][0], c + lineGap[i][1], side)){
+                        step_table_insert(&(general_steps[side][r][c]), r + lineGap[i][0], c + lineGap[i][1], r, c);
+                    }
+                }
+
+                /* pawn, forward always, left and right after crossing the river. */
+                int forward = (side == PS_UP) ? +1 : -1;
+                if (board_in_actual(r + forward, c)){
+                    step_table_insert(&(pawn_steps[side][r][c]), r + forward, c, r, c);
+                }
+
+                if ((side == PS_UP) ? (r > BOARD_RIVER_UP) : (r < BOARD_RIVER_DOWN)){
+                    if (board_in_actual(r, c - 1)){
+                        step_table_insert(&(pawn_steps[side][r][c]), r, c - 1, r, c);
+                    }
+
+                    if (board_in_actual(r, c + 1)){
+                        step_table_insert(&(pawn_steps[side][r][c]), r, c + 1, r, c);
+                    }
+                }
+            }
+        }
+    }
+}
+
+static void opening_book_init(void);
+
+/* initialize the global lookup tables, must be called once before making any board. */
+static void tables_init(void){
+    unsigned long long state = 0x20240521ULL;
+    int p, r, c;
+
+    for (p = P_UP; p <= P_DG; ++p){
+        for (r = 0; r < BOARD_ROW_LEN; ++r){
+            for (c = 0; c < BOARD_COL_LEN; ++c){
+                zobrist_piece[p][r][c] = random_next(&state);
+
+                if (r >= BOARD_ACTUAL_ROW_BEGIN && r < BOARD_ACTUAL_ROW_BEGIN + BOARD_ACTUAL_ROW_LEN &&
+                    c >= BOARD_ACTUAL_COL_BEGIN && c < BOARD_ACTUAL_COL_BEGIN + BOARD_ACTUAL_COL_LEN){
+                    piece_square_value[p][r][c] = piece_get_value[p] + piece_get_pos_value[p][r - BOARD_ACTUAL_ROW_BEGIN][c - BOARD_ACTUAL_COL_BEGIN];
+                }
+            }
+        }
+    }
+
+    zobrist_side = random_next(&state);
+    step_tables_init();
+    opening_book_init();
+}
+
+static long board_calc_score(const struct ChessBoard* cb);
+
+/* calculate a chess board's zobrist hash from scratch. */
+static unsigned long long board_calc_hash(const struct ChessBoard* cb){
+    assert(cb != NULL);
+
+    unsigned long long hash = (cb->side == PS_UP) ? zobrist_side : 0;
+
+    int r, c;
+    for (r = 0; r < BOARD_ROW_LEN; ++r){
+        for (c = 0; c < BOARD_COL_LEN; ++c){
+            hash ^= zobrist_piece[cb->data[r][c]][r][c];
+        }
+    }
+
+    return hash;
+}
+
+/* calculate the zobrist hash of a chess board mirrored left to right from scratch. */
+static unsigned long long board_calc_mirror_hash(const struct ChessBoard* cb){
+    assert(cb != NULL);
+
+    unsigned long long hash = (cb->side == PS_UP) ? zobrist_side : 0;
+
+    int r, c;
+    for (r = 0; r < BOARD_ROW_LEN; ++r){
+        for (c = 0; c < BOARD_COL_LEN; ++c){
+            hash ^= zobrist_piece[cb->data[r][c]][r][BOARD_MIRROR_COL(c)];
+        }
+    }
+
+    return hash;
+}
+
+/*
+    the same key for a board and its left-right mirror: the smaller of both hashes.
+    mirrored is set if the key is the mirror hash, moves kept under this key are mirrored then.
+*/
+static unsigned long long board_canonical_hash(const struct ChessBoard* cb, int* mirrored){
+    *mirrored = cb->mirrorHash < cb->hash;
+    return *mirrored ? cb->mirrorHash : cb->hash;
+}
+
+/* mirror a move left to right, move and mirrored may be the same. */
+static void move_mirror(const struct MoveNode* move, struct MoveNode* mirrored){
+    int beginCol = move->beginCol, endCol = move->endCol;
+
+    mirrored->beginRow = move->beginRow;
+    mirrored->endRow = move->endRow;
+    mirrored->beginCol = BOARD_MIRROR_COL(beginCol);
+    mirrored->endCol = BOARD_MIRROR_COL(endCol);
+}
+
+/* init a chess board with the default template, down side moves first. */
+static void board_init(struct ChessBoard* cb){
+    assert(cb != NULL);
+
+    memcpy(cb->data, &CHESS_BOARD_DEFAULT_TEMPLATE, BOARD_ROW_LEN * BOARD_COL_LEN * sizeof(enum Piece));
+    cb->side = PS_DOWN;
+    cb->hash = board_calc_hash(cb);
+    cb->mirrorHash = board_calc_mirror_hash(cb);
+    cb->score = board_calc_score(cb);
+}
+
+static void board_print_to_console(const struct ChessBoard* cb){
+    assert(cb != NULL);
+
+    int splitLineIndex = BOARD_ACTUAL_ROW_BEGIN + (BOARD_ACTUAL_ROW_LEN / 2);
+    int endRow = BOARD_ACTUAL_ROW_BEGIN + BOARD_ACTUAL_ROW_LEN;
+    int endCol = BOARD_ACTUAL_COL_BEGIN + BOARD_ACTUAL_COL_LEN;
+    int n = BOARD_ACTUAL_ROW_LEN - 1;
+
+    printf("\n    +-------------------+\n");
+
+    int r, c;
+    for (r = BOARD_ACTUAL_ROW_BEGIN; r < endRow; ++r) {
+        if (r == splitLineIndex){
+            printf("    |===================|\n");
+            printf("    |===================|\n");
+        }
+
+        printf(" %d  | ", n--);
+
+        for (c = BOARD_ACTUAL_COL_BEGIN; c < endCol; ++c){
+            printf("%c ", piece_get_char[(cb->data[r][c])]);
+        }
+
+        printf("|\n");
+    }
+
+    printf("    +-------------------+\n");
+    printf("\n      a b c d e f g h i\n\n");
+}
+
+/* 
+    move and record what board_undo() needs into hist, never check any game rules.
+    the side to move is switched, hash and score are updated incrementally.
+*/
+static void board_move(struct ChessBoard* cb, const struct MoveNode* moveNode, struct HistoryNode* hist){
+    assert(cb != NULL && moveNode != NULL && hist != NULL);
+
+    int br = moveNode->beginRow, bc = moveNode->beginCol;
+    int er = moveNode->endRow, ec = moveNode->endCol;
+    enum Piece beginPiece = cb->data[br][bc];
+    enum Piece endPiece = cb->data[er][ec];
+
+    /* record the history. */
+    memcpy(&(hist->move), moveNode, sizeof(struct MoveNode));
+    hist->beginPiece = beginPiece;
+    hist->endPiece = endPiece;
+    hist->hash = cb->hash;
+    hist->mirrorHash = cb->mirrorHash;
+    hist->score = cb->score;
+
+    /* move the pieces. */
+    cb->data[br][bc] = P_EE;
+    cb->data[er][ec] = beginPiece;
+
+    cb->hash ^= zobrist_piece[beginPiece][br][bc] ^ zobrist_piece[beginPiece][er][ec] ^ zobrist_piece[endPiece][er][ec] ^ zobrist_side;
+    cb->mirrorHash ^= zobrist_piece[beginPiece][br][BOARD_MIRROR_COL(bc)] ^ zobrist_piece[beginPiece][er][BOARD_MIRROR_COL(ec)] ^
+                      zobrist_piece[endPiece][er][BOARD_MIRROR_COL(ec)] ^ zobrist_side;
+    cb->score += piece_square_value[beginPiece][er][ec] - piece_square_value[beginPiece][br][bc] - piece_square_value[endPiece][er][ec];
+    cb->side = piece_side_get_reverse_side[cb->side];
+}
+
+/* undo the move recorded in hist, it must be the last move played on this board. */
+static void board_undo(struct ChessBoard* cb, const struct HistoryNode* hist){
+    assert(cb != NULL && hist != NULL);
+
+    cb->data[hist->move.beginRow][hist->move.beginCol] = hist->beginPiece;
+    cb->data[hist->move.endRow][hist->move.endCol] = hist->endPiece;
+    cb->hash = hist->hash;
+    cb->mirrorHash = hist->mirrorHash;
+    cb->score = hist->score;
+    cb->side = piece_side_get_reverse_side[cb->side];
+}
+
+/* return 0 if out of memory. */
+static int game_record_init(struct GameRecord* rec){
+    assert(rec != NULL);
+
+    rec->history = (struct HistoryNode*)malloc(GAME_RECORD_INIT_CAPACITY * sizeof(struct HistoryNode));
+    rec->length = 0;
+    rec->capacity = (rec->history != NULL) ? GAME_RECORD_INIT_CAPACITY : 0;
+    return rec->history != NULL;
+}
+
+static void game_record_free(struct GameRecord* rec){
+    assert(rec != NULL);
+
+    free(rec->history);
+    rec->history = NULL;
+    rec->length = rec->capacity = 0;
+}
+
+/* append a slot at the end of the record, grow the record if full. return NULL if out of memory, the record is not changed then. */
+static struct HistoryNode* game_record_push(struct GameRecord* rec){
+    assert(rec != NULL);
+
+    if (rec->length == rec->capacity){
+        struct HistoryNode* history = (struct HistoryNode*)realloc(rec->history, rec->capacity * 2 * sizeof(struct HistoryNode));
+        if (history == NULL){
+            return NULL;
+        }
+
+        rec->history = history;
+        rec->capacity *= 2;
+    }
+
+    return &(rec->history[(rec->length)++]);
+}
+
+/* 
+    making a new game, return NULL if out of memory.
+    you should call game_free() on the returned value later.
+*/
+static struct Game* game_make_new(void){
+    struct Game* game = (struct Game*)malloc(sizeof(struct Game));
+    if (game == NULL){
+        return NULL;
+    }
+
+    board_init(&(game->board));
+    if (!game_record_init(&(game->record))){
+        free(game);
+        return NULL;
+    }
+
+    return game;
+}
+
+static void game_free(struct Game* game){
+    if (game != NULL){
+        game_record_free(&(game->record));
+        free(game);
+    }
+}
+
+/* 
+    play a move and record it, never check any game rules.
+    too many moves is considered as a draw, then the move is not played and GS_DRAW_TOO_LONG is returned.
+*/
+static enum GameStatus game_move(struct Game* game, const struct MoveNode* moveNode){
+    assert(game != NULL && moveNode != NULL);
+
+    if (game->record.length >= MAX_HISOTRY_BUF_LEN){
+        return GS_DRAW_TOO_LONG;
+    }
+
+    struct HistoryNode* hist = game_record_push(&(game->record));
+    if (hist == NULL){
+        return GS_OUT_OF_MEMORY;
+    }
+
+    board_move(&(game->board), moveNode, hist);
+    return GS_ONGOING;
+}
+
+/* undo the previous move, if history is empty, do nothing. */
+static void game_undo(struct Game* game){
+    assert(game != NULL);
+
+    if (game->record.length > 0){
+        --(game->record.length);
+        board_undo(&(game->board), &(game->record.history[game->record.length]));
+    }
+}
+
+/* play a move inside the search, the undo information goes to the search-local stack. */
+static void search_move(struct SearchContext* ctx, const struct MoveNode* moveNode){
+    assert(ctx != NULL && ctx->ply < MAX_SEARCH_PLY);
+
+    board_move(&(ctx->board), moveNode, &(ctx->undo[ctx->ply]));
+    ++(ctx->ply);
+}
+
+static void search_undo(struct SearchContext* ctx){
+    assert(ctx != NULL && ctx->ply > 0);
+
+    --(ctx->ply);
+    board_undo(&(ctx->board), &(ctx->undo[ctx->ply]));
+}
+
+static void possible_move_insert(struct PossibleMoves* pm, int beginRow, int beginCol, int endRow, int endCol){
+    assert(pm != NULL);
+
+    struct MoveNode* currentMoveNode = &(pm->data[pm->len]);
+
+    currentMoveNode->beginRow = beginRow;
+    currentMoveNode->beginCol = beginCol;
+    currentMoveNode->endRow = endRow;
+    currentMoveNode->endCol = endCol;
+
+    ++(pm->len);
+}
+
+/* is p a piece of the given side ? with a constant side it is one or two compares, empty and out of board are of no side. */
+FORCE_INLINE int piece_is_side(enum Piece p, enum PieceSide side){
+    return (side == PS_UP) ? (int)p <= P_UG : ((int)p >= P_DP && (int)p <= P_DG);
+}
+
+FORCE_INLINE void board_try_insert_possible_move(struct ChessBoard* cb, struct PossibleMoves* pm, int beginRow, int beginCol, int endRow, int endCol, enum PieceSide side, int genMask){
+    assert(cb != NULL && pm != NULL);
+
+    enum Piece endP = cb->data[endRow][endCol];
+
+    if (endP == P_EE){
+        if (genMask & GEN_QUIET){
+            possible_move_insert(pm, beginRow, beginCol, endRow, endCol);
+        }
+    }
+    else if (piece_is_side(endP, SIDE_REVERSE(side))){   /* not out of chess board, and not the same side. */
+        if (genMask & GEN_CAPTURE){
+            possible_move_insert(pm, beginRow, beginCol, endRow, endCol);
+        }
+    }
+}
+
+/* walk a step table, every target is a possible move. */
+FORCE_INLINE void board_gen_possible_moves_by_steps(struct ChessBoard* cb, struct PossibleMoves* pm, int r, int c, const struct StepTable* st, enum PieceSide side, int genMask){
+    assert(cb != NULL && pm != NULL && st != NULL);
+
+    const struct StepTarget* target = st->targets;
+    const struct StepTarget* end = target + st->len;
+
+    for (; target != end; ++target){
+        board_try_insert_possible_move(cb, pm, r, c, target->row, target->col, side, genMask);
+    }
+}
+
+/* walk a step table, a target is a possible move only if its blocking square is empty. */
+FORCE_INLINE void board_gen_possible_moves_by_blocked_steps(struct ChessBoard* cb, struct PossibleMoves* pm, int r, int c, const struct StepTable* st, enum PieceSide side, int genMask){
+    assert(cb != NULL && pm != NULL && st != NULL);
+
+    const struct StepTarget* target = st->targets;
+    const struct StepTarget* end = target + st->len;
+
+    for (; target != end; ++target){
+        if (cb->data[target->blockRow][target->blockCol] == P_EE){
+            board_try_insert_possible_move(cb, pm, r, c, target->row, target->col, side, genMask);
+        }
+    }
+}
+
+FORCE_INLINE void board_gen_possible_moves_for_pawn(struct ChessBoard* cb, struct PossibleMoves* pm, int r, int c, enum PieceSide side, int genMask){
+	assert(cb != NULL && pm != NULL);
+
+    board_gen_possible_moves_by_steps(cb, pm, r, c, &(pawn_steps[side][r][c]), side, genMask);
+}
+
+FORCE_INLINE void board_gen_possible_moves_for_cannon_one_direction(struct ChessBoard* cb, struct PossibleMoves* pm, int r, int c, int rGap, int cGap, enum PieceSide side, int genMask){
+    assert(cb != NULL && pm != NULL);
+
+    int row, col;
+    enum Piece p;
+
+    for (row = r + rGap, col = c + cGap; ;row += rGap, col += cGap){
+        p = cb->data[row][col];
+
+        if (p == P_EE){    /* empty piece, then insert it. */
+            if (genMask & GEN_QUIET){
+                possible_move_insert(pm, r, c, row, col);
+            }
+        }
+        else {   /* upper piece, down piece or out of chess board, break immediately. */
+            break;
+        }
+    }
+
+    if (p != P_EO && (genMask & GEN_CAPTURE)){   /* not out of chess board, check if we can add an enemy piece. */
+        for (row = row + rGap, col = col + cGap; ;row += rGap, col += cGap){
+            p = cb->data[row][col];
+        
+            if (p == P_EE){    /* empty, then continue search. */
+                continue;
+            }
+            else if (piece_is_side(p, SIDE_REVERSE(side))){   /* enemy piece, then insert it and break. */
+                possible_move_insert(pm, r, c, row, col);
+                break;
+            }
+            else {    /* self side piece or out of chess board, break. */
+                break;
+            }
+        }
+    }
+}
+
+FORCE_INLINE void board_gen_possible_moves_for_cannon(struct ChessBoard* cb, struct PossibleMoves* pm, int r, int c, enum PieceSide side, int genMask){
+	assert(cb != NULL && pm != NULL);
+
+    /* go up, down, left, right. */
+    board_gen_possible_moves_for_cannon_one_direction(cb, pm, r, c, -1, 0, side, genMask);
+    board_gen_possible_moves_for_cannon_one_direction(cb, pm, r, c, +1, 0, side, genMask);
+    board_gen_possible_moves_for_cannon_one_direction(cb, pm, r, c, 0, -1, side, genMask);
+    board_gen_possible_moves_for_cannon_one_direction(cb, pm, r, c, 0, +1, side, genMask);
+}
+
+FORCE_INLINE void board_gen_possible_moves_for_rook_one_direction(struct ChessBoard* cb, struct PossibleMoves* pm, int r, int c, int rGap, int cGap, enum PieceSide side, int genMask){
+    assert(cb != NULL && pm != NULL);
+
+    int row, col;
+    enum Piece p;
+
+    for (row = r + rGap, col = c + cGap; ;row += rGap, col += cGap){
+        p = cb->data[row][col];
+
+        if (p == P_EE){    /* empty piece, then insert it. */
+            if (genMask & GEN_QUIET){
+                possible_move_insert(pm, r, c, row, col);
+            }
+        }
+        else {   /* upper piece, down piece or out of chess board, break immediately. */
+            break;
+        }
+    }
+
+    if (piece_is_side(p, SIDE_REVERSE(side)) && (genMask & GEN_CAPTURE)){   /* enemy piece, then insert it. */
+        possible_move_insert(pm, r, c, row, col);
+    }
+}
+
+FORCE_INLINE void board_gen_possible_moves_for_rook(struct ChessBoard* cb, struct PossibleMoves* pm, int r, int c, enum PieceSide side, int genMask){
+	assert(cb != NULL && pm != NULL);
+
+    /* go up, down, left, right. */
+    board_gen_possible_moves_for_rook_one_direction(cb, pm, r, c, -1, 0, side, genMask);
+    board_gen_possible_moves_for_rook_one_direction(cb, pm, r, c, +1, 0, side, genMask);
+    board_gen_possible_moves_for_rook_one_direction(cb, pm, r, c, 0, -1, side, genMask);
+    board_gen_possible_moves_for_rook_one_direction(cb, pm, r, c, 0, +1, side, genMask);
+}
+
+FORCE_INLINE void board_gen_possible_moves_for_knight(struct ChessBoard* cb, struct PossibleMoves* pm, int r, int c, enum PieceSide side, int genMask){
+	assert(cb != NULL && pm != NULL);
+
+    board_gen_possible_moves_by_blocked_steps(cb, pm, r, c, &(knight_steps[r][c]), side, genMask);
+}
+
+FORCE_INLINE void board_gen_possible_moves_for_bishop(struct ChessBoard* cb, struct PossibleMoves* pm, int r, int c, enum PieceSide side, int genMask){
+	assert(cb != NULL && pm != NULL);
+
+    board_gen_possible_moves_by_blocked_steps(cb, pm, r, c, &(bishop_steps[side][r][c]), side, genMask);
+}
+
+FORCE_INLINE void board_gen_possible_moves_for_advisor(struct ChessBoard* cb, struct PossibleMoves* pm, int r, int c, enum PieceSide side, int genMask){
+	assert(cb != NULL && pm != NULL);
+
+    board_gen_possible_moves_by_steps(cb, pm, r, c, &(advisor_steps[side][r][c]), side, genMask);
+}
+
+FORCE_INLINE void board_gen_possible_moves_for_general(struct ChessBoard* cb, struct PossibleMoves* pm, int r, int c, enum PieceSide side, int genMask){
+	assert(cb != NULL && pm != NULL);
+
+    board_gen_possible_moves_by_steps(cb, pm, r, c, &(general_steps[side][r][c]), side, genMask);
+
+    /* check if both generals faced each other directly. */
+    if (genMask & GEN_CAPTURE){
+        int gap = (side == PS_UP) ? +1 : -1;
+        enum Piece enemyGeneral = (side == PS_UP) ? P_DG : P_UG;
+        enum Piece p;
+        int row;
+
+        for (row = r + gap; (p = cb->data[row][c]) == P_EE; row += gap){
+        }
+
+        if (p == enemyGeneral){
+            possible_move_insert(pm, r, c, row, c);
+        }
+    }
+}
+
+/* generate possible moves for the piece p of side on (r, c). */
+FORCE_INLINE void board_gen_possible_moves_for_side_piece(struct ChessBoard* cb, struct PossibleMoves* pm, int r, int c, enum Piece p, enum PieceSide side, int genMask){
+    switch (piece_get_type[p])
+    {
+    case PT_PAWN:
+        board_gen_possible_moves_for_pawn(cb, pm, r, c, side, genMask);
+        break;
+    case PT_CANNON:
+        board_gen_possible_moves_for_cannon(cb, pm, r, c, side, genMask);
+        break;
+    case PT_ROOK:
+        board_gen_possible_moves_for_rook(cb, pm, r, c, side, genMask);
+        break;
+    case PT_KNIGHT:
+        board_gen_possible_moves_for_knight(cb, pm, r, c, side, genMask);
+        break;
+    case PT_BISHOP:
+        board_gen_possible_moves_for_bishop(cb, pm, r, c, side, genMask);
+        break;
+    case PT_ADVISOR:
+        board_gen_possible_moves_for_advisor(cb, pm, r, c, side, genMask);
+        break;
+    case PT_GENERAL:
+        board_gen_possible_moves_for_general(cb, pm, r, c, side, genMask);
+        break;
+    case PT_EMPTY:
+    case PT_OUT:
+    default:
+        break;
+    }
+}
+
+/* generate possible moves for the piece on (r, c), which must be an upper or down piece. */
+static void board_gen_possible_moves_for_piece(struct ChessBoard* cb, struct PossibleMoves* pm, int r, int c, int genMask){
+    assert(cb != NULL && pm != NULL);
+
+    enum Piece p = cb->data[r][c];
+
+    if (piece_is_side(p, PS_UP)){
+        board_gen_possible_moves_for_side_piece(cb, pm, r, c, p, PS_UP, genMask);
+    }
+    else if (piece_is_side(p, PS_DOWN)){
+        board_gen_possible_moves_for_side_piece(cb, pm, r, c, p, PS_DOWN, genMask);
+    }
+}
+
+/* the board scan of board_gen_possible_moves(), side and genMask are constants in every instance below. */
+FORCE_INLINE void board_gen_possible_moves_side(struct ChessBoard* cb, enum PieceSide side, int genMask, struct PossibleMoves* pm){
+	assert(cb != NULL && pm != NULL);
+
+    int endRow = BOARD_ACTUAL_ROW_BEGIN + BOARD_ACTUAL_ROW_LEN;
+    int endCol = BOARD_ACTUAL_COL_BEGIN + BOARD_ACTUAL_COL_LEN;
+
+    enum Piece p;
+    int r, c;
+    for (r = BOARD_ACTUAL_ROW_BEGIN; r < endRow; ++r) {
+        for (c = BOARD_ACTUAL_COL_BEGIN; c < endCol; ++c){
+            p = cb->data[r][c];
+
+            if (piece_is_side(p, side)){
+                board_gen_possible_moves_for_side_piece(cb, pm, r, c, p, side, genMask);
+            }
+        }
+    }
+}
+
+/* 
+    the move generators, one for every side and kind of moves, built at compile time from board_gen_possible_moves_side().
+    every test of the side or the kind of moves is folded away, the search calls them directly, see SIDE_INSTANCE().
+*/
+#define BOARD_GEN_INSTANCE(name, side, genMask) \
+    static void name(struct ChessBoard* cb, struct PossibleMoves* pm){ board_gen_possible_moves_side(cb, (side), (genMask), pm); }
+
+BOARD_GEN_INSTANCE(board_gen_quiets_up, PS_UP, GEN_QUIET)
+BOARD_GEN_INSTANCE(board_gen_quiets_down, PS_DOWN, GEN_QUIET)
+BOARD_GEN_INSTANCE(board_gen_captures_up, PS_UP, GEN_CAPTURE)
+BOARD_GEN_INSTANCE(board_gen_captures_down, PS_DOWN, GEN_CAPTURE)
+BOARD_GEN_INSTANCE(board_gen_all_up, PS_UP, GEN_ALL)
+BOARD_GEN_INSTANCE(board_gen_all_down, PS_DOWN, GEN_ALL)
+
+#undef BOARD_GEN_INSTANCE
+
+/* indexed by side and genMask. */
+static void (* const board_gen_instances[2][GEN_ALL + 1])(struct ChessBoard* cb, struct PossibleMoves* pm) = {
+    { NULL, board_gen_quiets_up, board_gen_captures_up, board_gen_all_up },
+    { NULL, board_gen_quiets_down, board_gen_captures_down, board_gen_all_down }
+};
+
+/* 
+    generate possible moves for one side, the moves are appended to pm. 
+    genMask tells which kind of moves are wanted: GEN_QUIET, GEN_CAPTURE or GEN_ALL.
+*/
+static void board_gen_possible_moves(struct ChessBoard* cb, enum PieceSide side, int genMask, struct PossibleMoves* pm){
+	assert(cb != NULL && pm != NULL && (side == PS_UP || side == PS_DOWN) && genMask >= GEN_QUIET && genMask <= GEN_ALL);
+
+    board_gen_instances[side][genMask](cb, pm);
+}
+
+/* is the square inside the 9 palace of the given side ? */
+static int board_in_palace(int r, int c, enum PieceSide side){
+    if (side == PS_UP){
+        return r >= BOARD_9_PALACE_UP_TOP && r <= BOARD_9_PALACE_UP_BOTTOM && c >= BOARD_9_PALACE_UP_LEFT && c <= BOARD_9_PALACE_UP_RIGHT;
+    }
+    else {
+        return r >= BOARD_9_PALACE_DOWN_TOP && r <= BOARD_9_PALACE_DOWN_BOTTOM && c >= BOARD_9_PALACE_DOWN_LEFT && c <= BOARD_9_PALACE_DOWN_RIGHT;
+    }
+}
+
+/*
+    find the least valuable piece of bySide that can move to square (r, c), its square is written to fromRow and fromCol.
+    return 0 if there is no such piece. the piece on (r, c) is not checked, it could even be bySide's own piece,
+    except that the facing general only counts when (r, c) holds the enemy general.
+*/
+FORCE_INLINE int board_least_valuable_attacker_side(const struct ChessBoard* cb, int r, int c, enum PieceSide bySide, int* fromRow, int* fromCol){
+    assert(cb != NULL && fromRow != NULL && fromCol != NULL);
+
+    static const int lineGap[4][2] = { { -1, 0 }, { +1, 0 }, { 0, -1 }, { 0, +1 } };
+    static const int diagonalGap[4][2] = { { -1, -1 }, { -1, +1 }, { +1, -1 }, { +1, +1 } };
+
+    enum Piece target = cb->data[r][c];
+    enum Piece rook = (bySide == PS_UP) ? P_UR : P_DR;
+    enum Piece cannon = (bySide == PS_UP) ? P_UC : P_DC;
+    enum Piece knight = (bySide == PS_UP) ? P_UN : P_DN;
+    enum Piece bishop = (bySide == PS_UP) ? P_UB : P_DB;
+    enum Piece advisor = (bySide == PS_UP) ? P_UA : P_DA;
+    enum Piece general = (bySide == PS_UP) ? P_UG : P_DG;
+    enum Piece pawn = (bySide == PS_UP) ? P_UP : P_DP;
+    int pawnForward = (bySide == PS_UP) ? +1 : -1;
+    int inPalace = board_in_palace(r, c, bySide);
+    int row, col, i;
+    enum Piece p;
+
+    /* the first and the second piece on every line, for rook, cannon and the facing general. */
+    int firstRow[4], firstCol[4], secondRow[4], secondCol[4];
+
+#define FOUND_ATTACKER(row_, col_) do { *fromRow = (row_); *fromCol = (col_); return 1; } while (0)
+
+    /* advisor and bishop are the cheapest. */
+    for (i = 0; inPalace && i < 4; ++i){
+        if (cb->data[r + diagonalGap[i][0]][c + diagonalGap[i][1]] == advisor){
+            FOUND_ATTACKER(r + diagonalGap[i][0], c + diagonalGap[i][1]);
+        }
+    }
+
+    /* bishop stays on its own side of the river and needs an empty Xiang Yan. */
+    if ((bySide == PS_UP && r <= BOARD_RIVER_UP) || (bySide == PS_DOWN && r >= BOARD_RIVER_DOWN)){
+        for (i = 0; i < 4; ++i){
+            if (cb->data[r + 2 * diagonalGap[i][0]][c + 2 * diagonalGap[i][1]] == bishop && cb->data[r + diagonalGap[i][0]][c + diagonalGap[i][1]] == P_EE){
+                FOUND_ATTACKER(r + 2 * diagonalGap[i][0], c + 2 * diagonalGap[i][1]);
+            }
+        }
+    }
+
+    /* pawn, forward always, left and right only after crossing the river. */
+    if (cb->data[r - pawnForward][c] == pawn){
+        FOUND_ATTACKER(r - pawnForward, c);
+    }
+
+    if ((bySide == PS_UP && r > BOARD_RIVER_UP) || (bySide == PS_DOWN && r < BOARD_RIVER_DOWN)){
+        if (cb->data[r][c - 1] == pawn){
+            FOUND_ATTACKER(r, c - 1);
+        }
+
+        if (cb->data[r][c + 1] == pawn){
+            FOUND_ATTACKER(r, c + 1);
+        }
+    }
+
+    /* knight, the lame leg is next to the knight, not next to the target square. */
+    for (i = 0; i < 4; ++i){
+        int dr = diagonalGap[i][0], dc = diagonalGap[i][1];
+
+        if (cb->data[r + 2 * dr][c + dc] == knight && cb->data[r + dr][c + dc] == P_EE){
+            FOUND_ATTACKER(r + 2 * dr, c + dc);
+        }
+
+        if (cb->data[r + dr][c + 2 * dc] == knight && cb->data[r + dr][c + dc] == P_EE){
+            FOUND_ATTACKER(r + dr, c + 2 * dc);
+        }
+    }
+
+    /* walk 4 lines, remember the first piece and the one behind it. */
+    for (i = 0; i < 4; ++i){
+        for (row = r + lineGap[i][0], col = c + lineGap[i][1]; (p = cb->data[row][col]) == P_EE; row += lineGap[i][0], col += lineGap[i][1]){
+        }
+
+        firstRow[i] = row;
+        firstCol[i] = col;
+
+        if (p != P_EO){
+            for (row += lineGap[i][0], col += lineGap[i][1]; cb->data[row][col] == P_EE; row += lineGap[i][0], col += lineGap[i][1]){
+            }
+        }
+
+        secondRow[i] = row;
+        secondCol[i] = col;
+    }
+
+    for (i = 0; i < 4; ++i){
+        if (cb->data[secondRow[i]][secondCol[i]] == cannon && cb->data[firstRow[i]][firstCol[i]] != P_EO){
+            FOUND_ATTACKER(secondRow[i], secondCol[i]);
+        }
+    }
+
+    for (i = 0; i < 4; ++i){
+        if (cb->data[firstRow[i]][firstCol[i]] == rook){
+            FOUND_ATTACKER(firstRow[i], firstCol[i]);
+        }
+    }
+
+    /* general, next to the target within the 9 palace, or facing the enemy general. */
+    for (i = 0; inPalace && i < 4; ++i){
+        if (cb->data[r + lineGap[i][0]][c + lineGap[i][1]] == general){
+            FOUND_ATTACKER(r + lineGap[i][0], c + lineGap[i][1]);
+        }
+    }
+
+    if (piece_get_type[target] == PT_GENERAL && piece_get_side[target] != bySide){
+        for (i = 0; i < 2; ++i){    /* only the vertical lines. */
+            if (cb->data[firstRow[i]][firstCol[i]] == general){
+                FOUND_ATTACKER(firstRow[i], firstCol[i]);
+            }
+        }
+    }
+
+#undef FOUND_ATTACKER
+
+    return 0;
+}
+
+static int board_least_valuable_attacker_up(const struct ChessBoard* cb, int r, int c, int* fromRow, int* fromCol){
+    return board_least_valuable_attacker_side(cb, r, c, PS_UP, fromRow, fromCol);
+}
+
+static int board_least_valuable_attacker_down(const struct ChessBoard* cb, int r, int c, int* fromRow, int* fromCol){
+    return board_least_valuable_attacker_side(cb, r, c, PS_DOWN, fromRow, fromCol);
+}
+
+FORCE_INLINE int board_least_valuable_attacker(const struct ChessBoard* cb, int r, int c, enum PieceSide bySide, int* fromRow, int* fromCol){
+    return SIDE_INSTANCE(board_least_valuable_attacker, bySide)(cb, r, c, fromRow, fromCol);
+}
+
+/* can any piece of bySide move to square (r, c) ? see board_least_valuable_attacker(). */
+FORCE_INLINE int board_is_square_attacked(const struct ChessBoard* cb, int r, int c, enum PieceSide bySide){
+    int fromRow, fromCol;
+    return board_least_valuable_attacker(cb, r, c, bySide, &fromRow, &fromCol);
+}
+
+/* the max number of captures in one exchange, every piece on the board plus one. */
+#define MAX_EXCHANGE_LEN 33
+
+/*
+    static exchange evaluation: what the side playing the move wins, if both sides keep
+    taking back on the target square with their least valuable piece, and each may stop when it likes.
+    the pieces really come off the board while we go, so cannon screens and knight legs change as in the game.
+    cb is restored before return.
+*/
+static int board_see(struct ChessBoard* cb, const struct MoveNode* move){
+    assert(cb != NULL && move != NULL);
+
+    int r = move->endRow, c = move->endCol;
+    int gain[MAX_EXCHANGE_LEN];
+    struct HistoryNode changes[MAX_EXCHANGE_LEN];    /* only move and the pieces are used, to put everything back. */
+    int depth = 0, n = 0;
+    int fromRow = move->beginRow, fromCol = move->beginCol;
+    enum Piece attacker = cb->data[fromRow][fromCol];
+    enum PieceSide side = piece_get_side[attacker];
+
+    gain[0] = (cb->data[r][c] == P_EE) ? 0 : abs(piece_get_value[cb->data[r][c]]);    /* a quiet move can be evaluated too. */
+
+    while (1){
+        /* take on the target square. */
+        changes[n].move.beginRow = fromRow;
+        changes[n].move.beginCol = fromCol;
+        changes[n].beginPiece = cb->data[fromRow][fromCol];
+        changes[n].endPiece = cb->data[r][c];
+        ++n;
+
+        cb->data[r][c] = cb->data[fromRow][fromCol];
+        cb->data[fromRow][fromCol] = P_EE;
+        side = piece_side_get_reverse_side[side];
+
+        if (n == MAX_EXCHANGE_LEN - 1 || !board_least_valuable_attacker(cb, r, c, side, &fromRow, &fromCol)){
+            break;
+        }
+
+        ++depth;
+        gain[depth] = abs(piece_get_value[cb->data[r][c]]) - gain[depth - 1];
+    }
+
+    while (n > 0){
+        --n;
+        cb->data[changes[n].move.beginRow][changes[n].move.beginCol] = changes[n].beginPiece;
+        cb->data[r][c] = changes[n].endPiece;
+    }
+
+    while (depth > 0){
+        gain[depth - 1] = -COMPARE_MAX(-gain[depth - 1], gain[depth]);
+        --depth;
+    }
+
+    return gain[0];
+}
+
+/* is the general of the given side attacked ? if the general has been captured, return 0. */
+FORCE_INLINE int board_is_in_check(const struct ChessBoard* cb, enum PieceSide side){
+    assert(cb != NULL);
+
+    enum Piece general = (side == PS_UP) ? P_UG : P_DG;
+    int top = (side == PS_UP) ? BOARD_9_PALACE_UP_TOP : BOARD_9_PALACE_DOWN_TOP;
+    int left = (side == PS_UP) ? BOARD_9_PALACE_UP_LEFT : BOARD_9_PALACE_DOWN_LEFT;
+
+    int r, c;
+    for (r = top; r < top + 3; ++r){
+        for (c = left; c < left + 3; ++c){
+            if (cb->data[r][c] == general){
+                return board_is_square_attacked(cb, r, c, SIDE_REVERSE(side));
+            }
+        }
+    }
+
+    return 0;
+}
+
+/*
+    after the move in hist has been played on cb, does the moved piece chase an enemy piece ?
+    a chase is a new threat by a piece other than general or pawn, on an enemy piece which is either 
+    unprotected or worth more than the attacker. generals and pawns that have not crossed the river can't be chased.
+    a threat is new if the moved piece did not attack that piece from its begin square before the move.
+*/
+static int board_move_is_chase(const struct ChessBoard* cb, const struct HistoryNode* hist){
+    assert(cb != NULL && hist != NULL);
+
+    enum Piece attacker = hist->beginPiece;
+    if (piece_get_type[attacker] == PT_GENERAL || piece_get_type[attacker] == PT_PAWN){
+        return 0;
+    }
+
+    struct PossibleMoves pm, pmBefore;
+    struct ChessBoard tmp;
+    struct HistoryNode tmpHist;
+    pm.len = 0;
+    pmBefore.len = 0;
+    memcpy(&tmp, cb, sizeof(struct ChessBoard));
+
+    /* what the piece attacked from its begin square before the move. */
+    board_undo(&tmp, hist);
+    board_gen_possible_moves_for_piece(&tmp, &pmBefore, hist->move.beginRow, hist->move.beginCol, GEN_CAPTURE);
+    memcpy(&tmp, cb, sizeof(struct ChessBoard));
+
+    board_gen_possible_moves_for_piece(&tmp, &pm, hist->move.endRow, hist->move.endCol, GEN_CAPTURE);
+
+    size_t i, j;
+    for (i = 0; i < pm.len; ++i){
+        struct MoveNode* m = &(pm.data[i]);
+        enum Piece target = tmp.data[m->endRow][m->endCol];
+        enum PieceSide targetSide = piece_get_side[target];
+
+        if (target == P_EE || piece_get_type[target] == PT_GENERAL){
+            continue;
+        }
+
+        for (j = 0; j < pmBefore.len; ++j){
+            if (pmBefore.data[j].endRow == m->endRow && pmBefore.data[j].endCol == m->endCol){
+                break;
+            }
+        }
+
+        if (j < pmBefore.len){
+            continue;
+        }
+
+        if (piece_get_type[target] == PT_PAWN && ((targetSide == PS_UP && m->endRow <= BOARD_RIVER_UP) || (targetSide == PS_DOWN && m->endRow >= BOARD_RIVER_DOWN))){
+            continue;
+        }
+
+        if (labs(piece_get_value[target]) > labs(piece_get_value[attacker])){
+            return 1;
+        }
+
+        /* protected means the target side can take back after the capture. */
+        board_move(&tmp, m, &tmpHist);
+        int isProtected = board_is_square_attacked(&tmp, m->endRow, m->endCol, targetSide);
+        board_undo(&tmp, &tmpHist);
+
+        if (!isProtected){
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+/* 
+	calculate a chess board's score. 
+	upper side value is negative, down side is positive.
+*/
+static long board_calc_score(const struct ChessBoard* cb){
+	assert(cb != NULL);
+	
+    long totalScore = 0;
+
+    int endRow = BOARD_ACTUAL_ROW_BEGIN + BOARD_ACTUAL_ROW_LEN;
+    int endCol = BOARD_ACTUAL_COL_BEGIN + BOARD_ACTUAL_COL_LEN;
+
+    enum Piece p;
+    int r, c;
+    for (r = BOARD_ACTUAL_ROW_BEGIN; r < endRow; ++r) {
+        for (c = BOARD_ACTUAL_COL_BEGIN; c < endCol; ++c){
+            p = cb->data[r][c];
+
+			if (p != P_EE){
+				totalScore += piece_get_value[p];
+				totalScore += piece_get_pos_value[p][r - BOARD_ACTUAL_ROW_BEGIN][c - BOARD_ACTUAL_COL_BEGIN];	
+            }
+        }
+    }
+
+    return totalScore;
+}
+
+/* 
+    positional terms of the evaluation, in score units (a pawn is 20), see board_calc_positional_score().
+    mobility counts the squares a rook, knight or cannon can move to.
+    a missing advisor or bishop costs the general's side in full when the enemy has EVAL_ATTACK_UNITS_MAX attack units,
+    2 for every rook, 1 for every knight and cannon, and less with fewer attackers.
+    an enemy rook, knight, cannon or pawn on or next to the palace is a palace attacker.
+    a cannon on a line of the enemy general with nothing between is an empty head cannon, with 2 pieces between
+    it gives check as soon as one of them leaves.
+*/
+#define EVAL_ROOK_MOBILITY 1
+#define EVAL_KNIGHT_MOBILITY 3
+#define EVAL_CANNON_MOBILITY 1
+#define EVAL_ADVISOR_MISSING 10
+#define EVAL_BISHOP_MISSING 8
+#define EVAL_ATTACK_UNITS_MAX 8
+#define EVAL_PALACE_ATTACKER 6
+#define EVAL_EMPTY_HEAD_CANNON 30
+#define EVAL_DOUBLE_SCREEN_CANNON 8
+
+/* 
+    the positional score is clamped to [-EVAL_LAZY_MARGIN, EVAL_LAZY_MARGIN], so a board whose material and position
+    values are further than this outside the search window is outside with the full evaluation too.
+*/
+#define EVAL_LAZY_MARGIN 50
+
+/* is (r, c) on or next to the palace of side ? the row beyond the palace toward the river counts too. */
+static int board_near_palace(int r, int c, enum PieceSide side){
+    if (c < BOARD_9_PALACE_UP_LEFT - 1 || c > BOARD_9_PALACE_UP_RIGHT + 1){    /* both palaces are on the same columns. */
+        return 0;
+    }
+
+    if (side == PS_UP){
+        return r >= BOARD_9_PALACE_UP_TOP && r <= BOARD_9_PALACE_UP_BOTTOM + 1;
+    }
+    else {
+        return r >= BOARD_9_PALACE_DOWN_TOP - 1 && r <= BOARD_9_PALACE_DOWN_BOTTOM;
+    }
+}
+
+/* count the empty squares from (r, c) going one direction, the piece that stops the walk is written to stop. */
+static int board_count_empty_line(const struct ChessBoard* cb, int r, int c, int rGap, int cGap, enum Piece* stop){
+    int n = 0;
+
+    for (r += rGap, c += cGap; cb->data[r][c] == P_EE; r += rGap, c += cGap){
+        ++n;
+    }
+
+    *stop = cb->data[r][c];
+    return n;
+}
+
+/* how many pieces are between two squares on the same row or column, the squares themselves are not counted. */
+static int board_count_between(const struct ChessBoard* cb, int r1, int c1, int r2, int c2){
+    int rGap = (r2 > r1) - (r2 < r1), cGap = (c2 > c1) - (c2 < c1);
+    int n = 0;
+
+    for (r1 += rGap, c1 += cGap; r1 != r2 || c1 != c2; r1 += rGap, c1 += cGap){
+        n += (cb->data[r1][c1] != P_EE);
+    }
+
+    return n;
+}
+
+/* 
+    the positional score of a board: mobility, safety of the generals and cannon screens, added to board_calc_score()
+    for the full evaluation. upper side value is negative, down side is positive. left-right mirrored boards have the same score.
+*/
+static int board_calc_positional_score(const struct ChessBoard* cb){
+    assert(cb != NULL);
+
+    static const int lineGap[4][2] = { { -1, 0 }, { +1, 0 }, { 0, -1 }, { 0, +1 } };
+
+    int bonus[2] = { 0, 0 };
+    int guards[2] = { 0, 0 };             /* advisor and bishop penalty avoided. */
+    int attackUnits[2] = { 0, 0 };
+    int palaceAttackers[2] = { 0, 0 };    /* pieces near the enemy palace. */
+    int generalRow[2] = { 0, 0 }, generalCol[2] = { 0, 0 };
+    int cannonRow[2][2], cannonCol[2][2], cannons[2] = { 0, 0 };    /* a side has 2 cannons at most. */
+
+    int endRow = BOARD_ACTUAL_ROW_BEGIN + BOARD_ACTUAL_ROW_LEN;
+    int endCol = BOARD_ACTUAL_COL_BEGIN + BOARD_ACTUAL_COL_LEN;
+
+    enum Piece p, stop;
+    enum PieceSide side;
+    int r, c, i, n;
+
+    for (r = BOARD_ACTUAL_ROW_BEGIN; r < endRow; ++r) {
+        for (c = BOARD_ACTUAL_COL_BEGIN; c < endCol; ++c){
+            p = cb->data[r][c];
+            if (p == P_EE){
+                continue;
+            }
+
+            side = piece_get_side[p];
+            switch (piece_get_type[p])
+            {
+            case PT_ROOK:
+                for (i = 0; i < 4; ++i){
+                    n = board_count_empty_line(cb, r, c, lineGap[i][0], lineGap[i][1], &stop);
+                    bonus[side] += EVAL_ROOK_MOBILITY * (n + (piece_get_side[stop] == piece_side_get_reverse_side[side]));
+                }
+
+                attackUnits[side] += 2;
+                break;
+            case PT_CANNON:
+                for (i = 0; i < 4; ++i){
+                    bonus[side] += EVAL_CANNON_MOBILITY * board_count_empty_line(cb, r, c, lineGap[i][0], lineGap[i][1], &stop);
+                }
+
+                if (cannons[side] < 2){
+                    cannonRow[side][cannons[side]] = r;
+                    cannonCol[side][cannons[side]] = c;
+                    ++(cannons[side]);
+                }
+
+                attackUnits[side] += 1;
+                break;
+            case PT_KNIGHT:
+                {
+                    const struct StepTable* st = &(knight_steps[r][c]);
+                    for (i = 0; i < st->len; ++i){
+                        if (cb->data[st->targets[i].blockRow][st->targets[i].blockCol] == P_EE && piece_get_side[cb->data[st->targets[i].row][st->targets[i].col]] != side){
+                            bonus[side] += EVAL_KNIGHT_MOBILITY;
+                        }
+                    }
+                }
+
+                attackUnits[side] += 1;
+                break;
+            case PT_ADVISOR:
+                guards[side] += EVAL_ADVISOR_MISSING;
+                break;
+            case PT_BISHOP:
+                guards[side] += EVAL_BISHOP_MISSING;
+                break;
+            case PT_GENERAL:
+                generalRow[side] = r;
+                generalCol[side] = c;
+                break;
+            default:
+                break;
+            }
+
+            if (piece_get_type[p] != PT_GENERAL && piece_get_type[p] != PT_ADVISOR && piece_get_type[p] != PT_BISHOP &&
+                board_near_palace(r, c, piece_side_get_reverse_side[side])){
+                ++palaceAttackers[side];
+            }
+        }
+    }
+
+    for (side = PS_UP; side <= PS_DOWN; ++side){
+        enum PieceSide enemy = piece_side_get_reverse_side[side];
+        int missing = 2 * (EVAL_ADVISOR_MISSING + EVAL_BISHOP_MISSING) - guards[side];
+
+        bonus[side] -= missing * COMPARE_MIN(attackUnits[enemy], EVAL_ATTACK_UNITS_MAX) / EVAL_ATTACK_UNITS_MAX;
+        bonus[side] -= EVAL_PALACE_ATTACKER * palaceAttackers[enemy];
+        for (i = 0; generalRow[side] != 0 && i < cannons[enemy]; ++i){
+            if (cannonRow[enemy][i] != generalRow[side] && cannonCol[enemy][i] != generalCol[side]){
+                continue;
+            }
+
+            n = board_count_between(cb, generalRow[side], generalCol[side], cannonRow[enemy][i], cannonCol[enemy][i]);
+            if (n == 0){
+                bonus[side] -= EVAL_EMPTY_HEAD_CANNON;
+            }
+            else if (n == 2){
+                bonus[side] -= EVAL_DOUBLE_SCREEN_CANNON;
+            }
+        }
+    }
+
+    n = bonus[PS_DOWN] - bonus[PS_UP];
+    return COMPARE_MAX(-EVAL_LAZY_MARGIN, COMPARE_MIN(n, EVAL_LAZY_MARGIN));
+}
+
+/* number of slots that fit in about sizeInMB megabytes, a power of 2, at least 1. */
+static size_t trans_table_count(size_t sizeInMB){
+    size_t count = 1;
+
+    while (count * 2 * sizeof(struct TransSlot) <= sizeInMB * 1024 * 1024){
+        count *= 2;
+    }
+
+    return count;
+}
+
+/* 
+    map anonymous memory for a private transposition table, zero filled, return NULL on failure.
+    with hugePages, explicit huge pages are tried first, then transparent huge pages are asked for.
+*/
+static void* trans_table_map_private(size_t size, int hugePages){
+    void* mapping = MAP_FAILED;
+
+#ifdef MAP_HUGETLB
+    if (hugePages){
+        mapping = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    }
+#endif
+
+    if (mapping == MAP_FAILED){
+        mapping = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (mapping == MAP_FAILED){
+            return NULL;
+        }
+
+#ifdef MADV_HUGEPAGE
+        if (hugePages){
+            madvise(mapping, size, MADV_HUGEPAGE);
+        }
+#endif
+    }
+
+    return mapping;
+}
+
+/* 
+    making a new transposition table, about sizeInMB megabytes, at least 1 entry, private to this process.
+    return NULL if out of memory. you should call trans_table_free() on the returned value later.
+*/
+static struct TransTable* trans_table_make_new(size_t sizeInMB, int hugePages){
+    struct TransTable* tt = (struct TransTable*)malloc(sizeof(struct TransTable));
+    size_t count = trans_table_count(sizeInMB);
+
+    if (tt == NULL){
+        return NULL;
+    }
+
+    tt->mappingSize = count * sizeof(struct TransSlot);
+    tt->mapping = trans_table_map_private(tt->mappingSize, hugePages);
+    if (tt->mapping == NULL){
+        free(tt);
+        return NULL;
+    }
+
+    tt->slots = (struct TransSlot*)tt->mapping;
+    tt->mask = count - 1;
+    tt->shared = 0;
+
+    return tt;
+}
+
+/* 
+    attach the transposition table in the POSIX shared memory segment name, like "/cnchess-tt", create it if there is none.
+    the first process sets the size to about sizeInMB megabytes, the others use the size it chose.
+    with hugePages, transparent huge pages are asked for, the kernel uses them for shared memory if
+    /sys/kernel/mm/transparent_hugepage/shmem_enabled allows it.
+    the segment stays after the last process exits, until shm_unlink(). return NULL on failure, errno tells why.
+*/
+static struct TransTable* trans_table_make_shared(const char* name, size_t sizeInMB, int hugePages){
+    assert(name != NULL);
+
+    struct TransSharedHeader* header;
+    struct stat st;
+    void* mapping;
+    int fd = shm_open(name, O_RDWR | O_CREAT, 0600);
+
+    if (fd < 0){
+        return NULL;
+    }
+
+    /* only one process sets up a new segment. */
+    if (flock(fd, LOCK_EX) != 0 || fstat(fd, &st) != 0){
+        close(fd);
+        return NULL;
+    }
+
+    if (st.st_size == 0){
+        st.st_size = (off_t)(sizeof(struct TransSharedHeader) + trans_table_count(sizeInMB) * sizeof(struct TransSlot));
+        if (ftruncate(fd, st.st_size) != 0){
+            close(fd);
+            return NULL;
+        }
+    }
+
+    mapping = mmap(NULL, (size_t)st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (mapping == MAP_FAILED){
+        close(fd);
+        return NULL;
+    }
+
+    header = (struct TransSharedHeader*)mapping;
+    if (header->count == 0){
+        header->count = ((size_t)st.st_size - sizeof(struct TransSharedHeader)) / sizeof(struct TransSlot);
+        memcpy(header->magic, TRANS_SHARED_MAGIC, sizeof(header->magic));
+    }
+
+    close(fd);
+
+    /* made by another build, or not a transposition table at all. */
+    if (memcmp(header->magic, TRANS_SHARED_MAGIC, sizeof(header->magic)) != 0 || (header->count & (header->count - 1)) != 0 ||
+        sizeof(struct TransSharedHeader) + header->count * sizeof(struct TransSlot) > (size_t)st.st_size){
+        munmap(mapping, (size_t)st.st_size);
+        errno = EINVAL;
+        return NULL;
+    }
+
+#ifdef MADV_HUGEPAGE
+    if (hugePages){
+        madvise(mapping, (size_t)st.st_size, MADV_HUGEPAGE);
+    }
+#endif
+
+    struct TransTable* tt = (struct TransTable*)malloc(sizeof(struct TransTable));
+    if (tt == NULL){
+        munmap(mapping, (size_t)st.st_size);
+        errno = ENOMEM;
+        return NULL;
+    }
+
+    tt->mapping = mapping;
+    tt->mappingSize = (size_t)st.st_size;
+    tt->slots = (struct TransSlot*)(header + 1);
+    tt->mask = header->count - 1;
+    tt->shared = 1;
+
+    return tt;
+}
+
+static void trans_table_free(struct TransTable* tt){
+    if (tt != NULL){
+        munmap(tt->mapping, tt->mappingSize);
+        free(tt);
+    }
+}
+
+/* a shared table is cleared for every process using it. */
+static void trans_table_clear(struct TransTable* tt){
+    assert(tt != NULL);
+    memset(tt->slots, 0, (tt->mask + 1) * sizeof(struct TransSlot));
+}
+
+/* 
+    making a new empty evaluation cache, return NULL if out of memory.
+    you should call free() on the returned value later.
+*/
+static struct EvalCache* eval_cache_make_new(void){
+    return (struct EvalCache*)calloc(1, sizeof(struct EvalCache));
+}
+
+static void eval_cache_clear(struct EvalCache* cache){
+    assert(cache != NULL);
+    memset(cache->entries, 0, sizeof(cache->entries));
+}
+
+/* 
+    entry layout in 64 bits: the move squares, 4 bits for each row and column of the padded board, in bits 0 - 15,
+    the score in bits 16 - 47, the depth in bits 48 - 55 and the bound in bits 56 - 57.
+    the bound of a stored entry is never TB_NONE, so data is not 0 and an empty slot never passes the check.
+*/
+static unsigned long long trans_table_pack(const struct MoveNode* move, int score, unsigned int depth, enum TransBound bound){
+    unsigned long long data = (unsigned long long)(move->beginRow | (move->beginCol << 4) | (move->endRow << 8) | (move->endCol << 12));
+
+    data |= (unsigned long long)(unsigned int)score << 16;
+    data |= (unsigned long long)COMPARE_MIN(depth, UCHAR_MAX) << 48;
+    data |= (unsigned long long)bound << 56;
+    return data;
+}
+
+static void trans_table_unpack(unsigned long long hash, unsigned long long data, struct TransEntry* entry){
+    entry->hash = hash;
+    entry->move.beginRow = (int)(data & 0xF);
+    entry->move.beginCol = (int)((data >> 4) & 0xF);
+    entry->move.endRow = (int)((data >> 8) & 0xF);
+    entry->move.endCol = (int)((data >> 12) & 0xF);
+    entry->score = (int)(unsigned int)(data >> 16);
+    entry->depth = (unsigned char)(data >> 48);
+    entry->bound = (unsigned char)((data >> 56) & 0x3);
+}
+
+/* find the entry of the given position and copy it to entry, return 0 if it is not stored. */
+static int trans_table_probe(const struct TransTable* tt, unsigned long long hash, struct TransEntry* entry){
+    if (tt == NULL){
+        return 0;
+    }
+
+    const struct TransSlot* slot = &(tt->slots[hash & tt->mask]);
+    unsigned long long check = __atomic_load_n(&(slot->check), __ATOMIC_RELAXED);
+    unsigned long long data = __atomic_load_n(&(slot->data), __ATOMIC_RELAXED);
+
+    if (data == 0 || (check ^ data) != hash){
+        return 0;
+    }
+
+    trans_table_unpack(hash, data, entry);
+    return 1;
+}
+
+/* 
+    store a search result, the bound is decided by the window [alpha, beta] the position was searched with.
+    an entry of another position is always replaced, the same position only by a deeper or equal search.
+*/
+static void trans_table_store(struct TransTable* tt, unsigned long long hash, unsigned int depth, int score, int alpha, int beta, const struct MoveNode* move){
+    if (tt == NULL){
+        return;
+    }
+
+    struct TransSlot* slot = &(tt->slots[hash & tt->mask]);
+    struct TransEntry old;
+    if (trans_table_probe(tt, hash, &old) && old.depth > depth){
+        return;
+    }
+
+    enum TransBound bound = (score <= alpha) ? TB_UPPER : ((score >= beta) ? TB_LOWER : TB_EXACT);
+    unsigned long long data = trans_table_pack(move, score, depth, bound);
+
+    __atomic_store_n(&(slot->check), hash ^ data, __ATOMIC_RELAXED);
+    __atomic_store_n(&(slot->data), data, __ATOMIC_RELAXED);
+}
+
+static int move_is_same(const struct MoveNode* left, const struct MoveNode* right){
+    return memcmp(left, right, sizeof(struct MoveNode)) == 0;
+}
+
+/* could side, the side to move, play this move ? used to verify moves that did not come from the generators. */
+FORCE_INLINE int board_is_pseudo_legal_side(struct ChessBoard* cb, const struct MoveNode* move, enum PieceSide side){
+    assert(cb != NULL && move != NULL);
+
+    enum Piece p = cb->data[move->beginRow][move->beginCol];
+    if (!piece_is_side(p, side)){
+        return 0;
+    }
+
+    struct PossibleMoves pm;
+    pm.len = 0;
+    board_gen_possible_moves_for_side_piece(cb, &pm, move->beginRow, move->beginCol, p, side, GEN_ALL);
+
+    size_t i;
+    for (i = 0; i < pm.len; ++i){
+        if (move_is_same(&(pm.data[i]), move)){
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+static int board_is_pseudo_legal_up(struct ChessBoard* cb, const struct MoveNode* move){
+    return board_is_pseudo_legal_side(cb, move, PS_UP);
+}
+
+static int board_is_pseudo_legal_down(struct ChessBoard* cb, const struct MoveNode* move){
+    return board_is_pseudo_legal_side(cb, move, PS_DOWN);
+}
+
+/* could the side to move play this move ? */
+static int board_is_pseudo_legal(struct ChessBoard* cb, const struct MoveNode* move){
+    return SIDE_INSTANCE(board_is_pseudo_legal, cb->side)(cb, move);
+}
+
+/* hashMove can be NULL if there is no stored best move. */
+static void move_picker_init(struct MovePicker* mp, const struct MoveNode* hashMove){
+    assert(mp != NULL);
+
+    mp->stage = PICK_HASH;
+    mp->hasHashMove = (hashMove != NULL);
+    mp->moves.len = 0;
+    mp->index = 0;
+    mp->badCount = 0;
+    mp->capturesOnly = 0;
+
+    if (hashMove != NULL){
+        memcpy(&(mp->hashMove), hashMove, sizeof(struct MoveNode));
+    }
+}
+
+/* a picker for quiescence search, it yields only the captures that don't lose material. */
+static void move_picker_init_quiescence(struct MovePicker* mp){
+    move_picker_init(mp, NULL);
+    mp->stage = PICK_GEN_CAPTURES;
+    mp->capturesOnly = 1;
+}
+
+/* yield the next move of side, the side to move, into move, return 0 when there is no move left. */
+FORCE_INLINE int move_picker_next_side(struct MovePicker* mp, struct SearchContext* ctx, struct MoveNode* move, enum PieceSide side){
+    assert(mp != NULL && ctx != NULL && move != NULL);
+
+    struct ChessBoard* cb = &(ctx->board);
+    const struct MoveNode* killers = ctx->killers[ctx->ply];
+    size_t i, best;
+
+    while (1){
+        switch (mp->stage)
+        {
+        case PICK_HASH:
+            mp->stage = PICK_GEN_CAPTURES;
+
+            if (mp->hasHashMove && SIDE_INSTANCE(board_is_pseudo_legal, side)(cb, &(mp->hashMove))){
+                memcpy(move, &(mp->hashMove), sizeof(struct MoveNode));
+                return 1;
+            }
+
+            mp->hasHashMove = 0;
+            break;
+        case PICK_GEN_CAPTURES:
+            mp->moves.len = 0;
+            SIDE_INSTANCE(board_gen_captures, side)(cb, &(mp->moves));
+            ctx->stats.generatedMoves += mp->moves.len;
+
+            for (i = 0; i < mp->moves.len; ++i){
+                struct MoveNode* m = &(mp->moves.data[i]);
+                mp->scores[i] = abs(piece_get_value[cb->data[m->endRow][m->endCol]]) * 8 - abs(piece_get_value[cb->data[m->beginRow][m->beginCol]]) / 8;
+            }
+
+            mp->index = 0;
+            mp->stage = PICK_CAPTURES;
+            break;
+        case PICK_CAPTURES:
+            while (mp->index < mp->moves.len){
+                /* selection sort, one step at a time, a cutoff saves sorting the rest. */
+                best = mp->index;
+                for (i = mp->index + 1; i < mp->moves.len; ++i){
+                    if (mp->scores[i] > mp->scores[best]){
+                        best = i;
+                    }
+                }
+
+                if (best != mp->index){
+                    struct MoveNode tmpMove = mp->moves.data[best];
+                    int tmpScore = mp->scores[best];
+                    mp->moves.data[best] = mp->moves.data[mp->index];
+                    mp->scores[best] = mp->scores[mp->index];
+                    mp->moves.data[mp->index] = tmpMove;
+                    mp->scores[mp->index] = tmpScore;
+                }
+
+                const struct MoveNode* m = &(mp->moves.data[(mp->index)++]);
+                if (mp->hasHashMove && move_is_same(m, &(mp->hashMove))){
+                    continue;
+                }
+
+                /* taking a piece worth at least the attacker never loses, otherwise ask the static exchange evaluation. */
+                if (abs(piece_get_value[cb->data[m->endRow][m->endCol]]) < abs(piece_get_value[cb->data[m->beginRow][m->beginCol]]) && board_see(cb, m) < 0){
+                    if (!mp->capturesOnly){
+                        memmove(&(mp->moves.data[(mp->badCount)++]), m, sizeof(struct MoveNode));
+                    }
+
+                    continue;
+                }
+
+                memcpy(move, m, sizeof(struct MoveNode));
+                return 1;
+            }
+
+            mp->index = 0;
+            mp->stage = mp->capturesOnly ? PICK_DONE : PICK_KILLERS;
+            break;
+        case PICK_KILLERS:
+            while (mp->index < 2){
+                const struct MoveNode* m = &(killers[(mp->index)++]);
+
+                if (mp->hasHashMove && move_is_same(m, &(mp->hashMove))){
+                    continue;
+                }
+
+                /* killers come from other positions, make sure it is still a quiet move here. */
+                if (cb->data[m->endRow][m->endCol] == P_EE && SIDE_INSTANCE(board_is_pseudo_legal, side)(cb, m)){
+                    memcpy(move, m, sizeof(struct MoveNode));
+                    return 1;
+                }
+            }
+
+            mp->stage = PICK_GEN_QUIETS;
+            break;
+        case PICK_GEN_QUIETS:
+            mp->moves.len = mp->badCount;
+            SIDE_INSTANCE(board_gen_quiets, side)(cb, &(mp->moves));
+            ctx->stats.generatedMoves += mp->moves.len - mp->badCount;
+
+            mp->index = mp->badCount;
+            mp->stage = PICK_QUIETS;
+            break;
+        case PICK_QUIETS:
+            while (mp->index < mp->moves.len){
+                const struct MoveNode* m = &(mp->moves.data[(mp->index)++]);
+
+                if ((mp->hasHashMove && move_is_same(m, &(mp->hashMove))) || move_is_same(m, &(killers[0])) || move_is_same(m, &(killers[1]))){
+                    continue;
+                }
+
+                memcpy(move, m, sizeof(struct MoveNode));
+                return 1;
+            }
+
+            mp->index = 0;
+            mp->stage = PICK_BAD_CAPTURES;
+            break;
+        case PICK_BAD_CAPTURES:
+            if (mp->index < mp->badCount){
+                memcpy(move, &(mp->moves.data[(mp->index)++]), sizeof(struct MoveNode));
+                return 1;
+            }
+
+            mp->stage = PICK_DONE;
+            break;
+        case PICK_DONE:
+        default:
+            return 0;
+        }
+    }
+}
+
+static int move_picker_next_up(struct MovePicker* mp, struct SearchContext* ctx, struct MoveNode* move){
+    return move_picker_next_side(mp, ctx, move, PS_UP);
+}
+
+static int move_picker_next_down(struct MovePicker* mp, struct SearchContext* ctx, struct MoveNode* move){
+    return move_picker_next_side(mp, ctx, move, PS_DOWN);
+}
+
+/* yield the next move into move, return 0 when there is no move left. the search calls the instances of the side directly. */
+static int move_picker_next(struct MovePicker* mp, struct SearchContext* ctx, struct MoveNode* move){
+    return SIDE_INSTANCE(move_picker_next, ctx->board.side)(mp, ctx, move);
+}
+
+/* a quiet move caused a cutoff, remember it for the other positions at the same ply. */
+static void search_update_killers(struct SearchContext* ctx, const struct MoveNode* move){
+    assert(ctx != NULL && move != NULL);
+
+    struct MoveNode* killers = ctx->killers[ctx->ply];
+
+    if (ctx->board.data[move->endRow][move->endCol] != P_EE || move_is_same(&(killers[0]), move)){
+        return;
+    }
+
+    memcpy(&(killers[1]), &(killers[0]), sizeof(struct MoveNode));
+    memcpy(&(killers[0]), move, sizeof(struct MoveNode));
+}
+
+/* the move just searched at the current ply is the best so far, it and the line found below it become this ply's principal variation. */
+static void search_update_pv(struct SearchContext* ctx, const struct MoveNode* move){
+    int ply = ctx->ply;
+    int childLen = (ply + 1 < MAX_SEARCH_PLY) ? ctx->pvLen[ply + 1] : 0;
+
+    memcpy(&(ctx->pv[ply][0]), move, sizeof(struct MoveNode));
+    memcpy(&(ctx->pv[ply][1]), &(ctx->pv[ply + 1][0]), COMPARE_MIN(childLen, MAX_SEARCH_PLY - 1) * sizeof(struct MoveNode));
+    ctx->pvLen[ply] = COMPARE_MIN(childLen + 1, MAX_SEARCH_PLY);
+}
+
+/* tuned by fixed node matches against the search with both prunings off, see cnchess_engine_set_option(). */
+static const struct SearchParams search_params_default = {
+    { -1, 20, 40 },        /* futility. */
+    { -1, -1, 30, 60 }     /* razoring. */
+};
+
+/* names of the search parameters, for search_params_set(). */
+static const struct {
+    const char* name;
+    size_t offset;
+} SEARCH_PARAM_NAMES[] = {
+    { "futility_margin_1", offsetof(struct SearchParams, futilityMargin[1]) },
+    { "futility_margin_2", offsetof(struct SearchParams, futilityMargin[2]) },
+    { "razor_margin_2", offsetof(struct SearchParams, razorMargin[2]) },
+    { "razor_margin_3", offsetof(struct SearchParams, razorMargin[3]) }
+};
+
+static void search_params_init(struct SearchParams* params){
+    memcpy(params, &search_params_default, sizeof(struct SearchParams));
+}
+
+/* set a search parameter by name, return 0 if there is no such parameter. */
+static int search_params_set(struct SearchParams* params, const char* name, int value){
+    assert(params != NULL && name != NULL);
+
+    size_t i;
+    for (i = 0; i < sizeof(SEARCH_PARAM_NAMES) / sizeof(SEARCH_PARAM_NAMES[0]); ++i){
+        if (strcmp(SEARCH_PARAM_NAMES[i].name, name) == 0){
+            *(int*)((char*)params + SEARCH_PARAM_NAMES[i].offset) = value;
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+static int search_futility_margin(const struct SearchContext* ctx, unsigned int depth){
+    return (depth <= SEARCH_FUTILITY_MAX_DEPTH) ? ctx->params->futilityMargin[depth] : -1;
+}
+
+static int search_razor_margin(const struct SearchContext* ctx, unsigned int depth){
+    return (depth <= SEARCH_RAZOR_MAX_DEPTH) ? ctx->params->razorMargin[depth] : -1;
+}
+
+/* prepare a search on a copy of cb, rec and tt can be NULL. */
+static void search_context_init(struct SearchContext* ctx, const struct ChessBoard* cb, const struct GameRecord* rec, struct TransTable* tt){
+    assert(ctx != NULL && cb != NULL);
+
+    memcpy(&(ctx->board), cb, sizeof(struct ChessBoard));
+    ctx->ply = 0;
+    ctx->record = rec;
+    ctx->tt = tt;
+    memset(ctx->killers, 0, sizeof(ctx->killers));
+    memset(&(ctx->stats), 0, sizeof(struct SearchStats));
+    ctx->params = &search_params_default;
+    ctx->nodeLimit = 0;
+    ctx->deadline = 0;
+    ctx->stop = NULL;
+    ctx->aborted = 0;
+    ctx->bestLineLen = 0;
+    ctx->timer.active = 0;
+    ctx->evalCache = NULL;
+    ctx->repetitions = 0;
+    ctx->evasions = 0;
+}
+
+/* limit the next search, 0 or NULL means no limit. */
+static void search_context_set_limits(struct SearchContext* ctx, unsigned long long nodes, long long timeMs, const volatile int* stop){
+    assert(ctx != NULL);
+
+    ctx->nodeLimit = nodes;
+    ctx->deadline = (timeMs > 0) ? time_now_ms() + timeMs : 0;
+    ctx->stop = stop;
+}
+
+/* 
+    budget the search by a game clock, the hard limit becomes the deadline.
+    the soft limit is a share of the main time plus most of the increment, or most of the byoyomi once that is more.
+    nothing is ever planned past the time on the clock minus the overhead.
+*/
+static void search_context_set_clock(struct SearchContext* ctx, const struct TimeControl* tc){
+    assert(ctx != NULL && tc != NULL);
+
+    struct TimeManager* tm = &(ctx->timer);
+    long long mainMs = COMPARE_MAX(tc->remainingMs - tc->overheadMs, 0);
+    long long capMs = COMPARE_MAX(tc->remainingMs + COMPARE_MAX(tc->byoyomiMs, 0) - tc->overheadMs, 1);
+    unsigned int movesToGo = (tc->movesToGo > 0) ? tc->movesToGo : TIME_DEFAULT_MOVES_TO_GO;
+    long long softMs = mainMs / movesToGo + COMPARE_MAX(tc->incrementMs, 0) * 3 / 4;
+
+    softMs = COMPARE_MAX(softMs, tc->byoyomiMs * 3 / 4);
+    tm->softMs = COMPARE_MAX(COMPARE_MIN(softMs, capMs), 1);
+    tm->hardMs = (movesToGo == 1) ? capMs : COMPARE_MIN(tm->softMs * TIME_HARD_FACTOR, capMs);
+    tm->start = time_now_ms();
+    tm->scale = 100;
+    tm->stable = 0;
+    tm->active = 1;
+
+    if (ctx->deadline == 0 || ctx->deadline > tm->start + tm->hardMs){
+        ctx->deadline = tm->start + tm->hardMs;
+    }
+}
+
+/* count a node and check the limits, return 1 if the search must stop. */
+static int search_count_node(struct SearchContext* ctx){
+    ++(ctx->stats.nodes);
+
+    if (ctx->nodeLimit != 0 && ctx->stats.nodes >= ctx->nodeLimit){
+        ctx->aborted = 1;
+    }
+    else if ((ctx->stats.nodes & SEARCH_POLL_MASK) == 0){
+        if ((ctx->stop != NULL && *(ctx->stop)) || (ctx->deadline != 0 && time_now_ms() >= ctx->deadline)){
+            ctx->aborted = 1;
+        }
+    }
+
+    return ctx->aborted;
+}
+
+/* 
+    the move played "back" plies ago, 1 means the last one. 
+    the search path is walked first, then the game record, NULL if there is no such move.
+*/
+static const struct HistoryNode* search_history_at(const struct SearchContext* ctx, int back){
+    assert(ctx != NULL && back > 0);
+
+    if (back <= ctx->ply){
+        return &(ctx->undo[ctx->ply - back]);
+    }
+
+    back -= ctx->ply;
+    if (ctx->record != NULL && (size_t)back <= ctx->record->length){
+        return &(ctx->record->history[ctx->record->length - back]);
+    }
+
+    return NULL;
+}
+
+/*
+    has the current position been seen before, since the last capture ?
+    if so, the cycle is judged by the rules and its score is written to score:
+    perpetual check loses, then perpetual chase loses, otherwise it is a draw.
+*/
+static int search_check_repetition(const struct SearchContext* ctx, int* score){
+    assert(ctx != NULL && score != NULL);
+
+    unsigned long long hash = ctx->board.hash;
+    const struct HistoryNode* hist;
+    int back, cycleLen = 0;
+
+    for (back = 1; (hist = search_history_at(ctx, back)) != NULL; ++back){
+        if (hist->endPiece != P_EE){    /* a capture can never be undone, positions before it won't come back. */
+            break;
+        }
+
+        if ((back & 1) == 0 && hist->hash == hash){
+            cycleLen = back;
+            break;
+        }
+    }
+
+    if (cycleLen == 0){
+        return 0;
+    }
+
+    /* 
+        replay the cycle backward on a copy, judge every move on the board just after it.
+        violation: 2 means every move of that side checks, 1 means every move checks or chases.
+    */
+    struct ChessBoard tmp;
+    int violation[2] = { 2, 2 };
+    memcpy(&tmp, &(ctx->board), sizeof(struct ChessBoard));
+
+    for (back = 1; back <= cycleLen; ++back){
+        hist = search_history_at(ctx, back);
+        enum PieceSide mover = piece_get_side[hist->beginPiece];
+
+        if (!board_is_in_check(&tmp, piece_side_get_reverse_side[mover])){
+            if (violation[mover] == 2){
+                violation[mover] = 1;
+            }
+
+            if (violation[mover] == 1 && !board_move_is_chase(&tmp, hist)){
+                violation[mover] = 0;
+            }
+        }
+
+        board_undo(&tmp, hist);
+    }
+
+    if (violation[PS_UP] > violation[PS_DOWN]){
+        *score = +SCORE_RULE_LOSS;
+    }
+    else if (violation[PS_UP] < violation[PS_DOWN]){
+        *score = -SCORE_RULE_LOSS;
+    }
+    else {
+        *score = 0;
+    }
+
+    return 1;
+}
+
+/* board_calc_positional_score() of ctx's board, from the evaluation cache if it is there. */
+static int search_positional_score(struct SearchContext* ctx){
+    unsigned long long hash = ctx->board.hash;
+    unsigned long long* slot = (ctx->evalCache != NULL) ? &(ctx->evalCache->entries[hash & (EVAL_CACHE_SIZE - 1)]) : NULL;
+    unsigned long long entry = (slot != NULL) ? __atomic_load_n(slot, __ATOMIC_RELAXED) : 0;
+    int score;
+
+    ++(ctx->stats.evalCacheProbes);
+    if (entry != 0 && (entry & ~EVAL_CACHE_SCORE_MASK) == (hash & ~EVAL_CACHE_SCORE_MASK)){
+        ++(ctx->stats.evalCacheHits);
+        return (short)(entry & EVAL_CACHE_SCORE_MASK);
+    }
+
+    if (((ctx->stats.evalCacheProbes - ctx->stats.evalCacheHits) & (EVAL_TIME_SAMPLE - 1)) == 1){
+        long long begin = time_now_ns();
+        score = board_calc_positional_score(&(ctx->board));
+        ctx->stats.evalTimeNs += (time_now_ns() - begin) * EVAL_TIME_SAMPLE;
+    }
+    else {
+        score = board_calc_positional_score(&(ctx->board));
+    }
+
+    if (slot != NULL){
+        __atomic_store_n(slot, (hash & ~EVAL_CACHE_SCORE_MASK) | ((unsigned long long)score & EVAL_CACHE_SCORE_MASK), __ATOMIC_RELAXED);
+    }
+
+    return score;
+}
+
+/* 
+    static evaluation of ctx's board from the view of side, the side to move. the material and position values
+    are kept by board_move(), the positional terms are costly and only wanted inside [alpha, beta]: 
+    a board whose cheap score is outside by more than EVAL_LAZY_MARGIN gets the cheap score (lazy evaluation).
+*/
+FORCE_INLINE int search_evaluate(struct SearchContext* ctx, int alpha, int beta, enum PieceSide side){
+    int score = SIDE_SIGN(side) * (int)ctx->board.score;
+
+    ++(ctx->stats.evals);
+    if (score + EVAL_LAZY_MARGIN <= alpha || score - EVAL_LAZY_MARGIN >= beta){
+        ++(ctx->stats.evalLazy);
+        return score;
+    }
+
+    return score + SIDE_SIGN(side) * search_positional_score(ctx);
+}
+
+static int quiescence_up(struct SearchContext* ctx, int alpha, int beta);
+static int quiescence_down(struct SearchContext* ctx, int alpha, int beta);
+static int negamax_up(struct SearchContext* ctx, unsigned int searchDepth, int alpha, int beta);
+static int negamax_down(struct SearchContext* ctx, unsigned int searchDepth, int alpha, int beta);
+
+/* 
+    quiescence search, only captures are searched until the position is quiet, so the score of a leaf
+    is not spoiled by a piece hanging there. captures that lose material by static exchange evaluation are pruned.
+    a general in check gets every move instead, up to QUIESCENCE_MAX_EVASIONS times on a line.
+    side is the side to move, scores are from its view.
+*/
+FORCE_INLINE int quiescence_side(struct SearchContext* ctx, int alpha, int beta, enum PieceSide side){
+    struct MovePicker picker;
+    struct MoveNode node;
+    int value;
+
+    if (search_count_node(ctx)){
+        return 0;
+    }
+
+    if (ctx->ply >= MAX_SEARCH_PLY){
+        return search_evaluate(ctx, alpha, beta, side);
+    }
+
+    ctx->pvLen[ctx->ply] = 0;
+
+    /*
+        the side to move may decline to capture and stand pat, unless its general is in check.
+        then every move is searched for an evasion, a general with none is captured by the reply.
+    */
+    int bestValue = -SCORE_INFINITE;
+    int evading = ctx->evasions < QUIESCENCE_MAX_EVASIONS && board_is_in_check(&(ctx->board), side);
+
+    if (evading){
+        ++(ctx->evasions);
+        move_picker_init(&picker, NULL);
+    }
+    else {
+        bestValue = search_evaluate(ctx, alpha, beta, side);
+
+        alpha = COMPARE_MAX(alpha, bestValue);
+        if (alpha >= beta){
+            return bestValue;
+        }
+
+        move_picker_init_quiescence(&picker);
+    }
+
+    while (SIDE_INSTANCE(move_picker_next, side)(&picker, ctx, &node)){
+        search_move(ctx, &node);
+        value = -SIDE_OTHER_INSTANCE(quiescence, side)(ctx, -beta, -alpha);
+        search_undo(ctx);
+
+        if (ctx->aborted){
+            break;
+        }
+
+        bestValue = COMPARE_MAX(bestValue, value);
+        alpha = COMPARE_MAX(alpha, bestValue);
+        if (alpha >= beta){
+            break;
+        }
+    }
+
+    ctx->evasions -= evading;
+    return ctx->aborted ? 0 : bestValue;
+}
+
+/* 
+    negamax algorithm, with alpha-beta pruning. side is the side to move, scores are from its view, bigger is better,
+    so both sides share this code. the transposition table keeps scores from the view of the side to move too.
+*/
+FORCE_INLINE int negamax_side(struct SearchContext* ctx, unsigned int searchDepth, int alpha, int beta, enum PieceSide side){
+    struct ChessBoard* cb = &(ctx->board);
+    int repetitionScore;
+
+    if (search_count_node(ctx)){
+        return 0;
+    }
+
+    if (ctx->ply < MAX_SEARCH_PLY){
+        ctx->pvLen[ctx->ply] = 0;
+    }
+
+    /* a repeated position is scored by the rules at once, never search the cycle again. */
+    if (search_check_repetition(ctx, &repetitionScore)){
+        ++(ctx->repetitions);
+        return SIDE_SIGN(side) * repetitionScore;
+    }
+
+    if (searchDepth == 0 || ctx->ply >= MAX_SEARCH_PLY){
+        return SIDE_INSTANCE(quiescence, side)(ctx, alpha, beta);
+    }
+
+    int alphaOrigin = alpha, betaOrigin = beta;
+    struct MovePicker picker;
+    struct MoveNode hashMove;
+
+    /* near the root, a board and its mirror share one entry, the mirrored one is more likely met there. */
+    int mirrored = 0;
+    unsigned long long key = (ctx->ply <= SEARCH_MIRROR_MAX_PLY) ? board_canonical_hash(cb, &mirrored) : cb->hash;
+    struct TransEntry entry;
+
+    ++(ctx->stats.ttProbes);
+    if (trans_table_probe(ctx->tt, key, &entry)){
+        ++(ctx->stats.ttHits);
+        if (entry.depth >= searchDepth){
+            if (entry.bound == TB_EXACT || (entry.bound == TB_LOWER && entry.score >= beta) || (entry.bound == TB_UPPER && entry.score <= alpha)){
+                return entry.score;
+            }
+        }
+
+        if (mirrored){
+            move_mirror(&(entry.move), &hashMove);
+        }
+        else {
+            memcpy(&hashMove, &(entry.move), sizeof(struct MoveNode));
+        }
+
+        move_picker_init(&picker, &hashMove);
+    }
+    else {
+        move_picker_init(&picker, NULL);
+    }
+
+    int value;
+    int searched = 0;
+    unsigned long long repetitionsBefore = ctx->repetitions;
+    struct MoveNode node, bestNode;
+    memset(&bestNode, 0, sizeof(struct MoveNode));
+
+    /*
+        frontier pruning, only at nodes with a null window, and never in check.
+        razoring: far below the window even with a margin, trust quiescence if it agrees.
+        futility: quiet moves which don't check can't gain the margin, they are skipped once a move is searched.
+    */
+    int isPv = beta - alpha > 1;
+    int staticEval = 0;
+    int razorMargin = search_razor_margin(ctx, searchDepth);
+    int futilityMargin = search_futility_margin(ctx, searchDepth);
+    int futile = 0;
+
+    if (!isPv && (razorMargin >= 0 || futilityMargin >= 0) && !board_is_in_check(cb, side)){
+        /* widened by the margins, lazy evaluation never changes what is pruned. */
+        staticEval = search_evaluate(ctx, alpha - COMPARE_MAX(razorMargin, futilityMargin), beta, side);
+
+        if (razorMargin >= 0 && staticEval + razorMargin <= alpha){
+            value = SIDE_INSTANCE(quiescence, side)(ctx, alpha, beta);
+            if (ctx->aborted || value <= alpha){
+                return value;
+            }
+        }
+
+        futile = futilityMargin >= 0 && staticEval + futilityMargin <= alpha;
+    }
+
+    int bestValue = -SCORE_INFINITE;
+
+    while (SIDE_INSTANCE(move_picker_next, side)(&picker, ctx, &node)){
+        int isCapture = cb->data[node.endRow][node.endCol] != P_EE;
+        search_move(ctx, &node);
+
+        if (futile && searched > 0 && !isCapture && !board_is_in_check(cb, SIDE_REVERSE(side))){
+            search_undo(ctx);
+            bestValue = COMPARE_MAX(bestValue, alpha);    /* a skipped move is only known not to beat alpha. */
+            continue;
+        }
+
+        /* principal variation search: the first move gets the full window, the others are only proved worse. */
+        if (searched++ == 0){
+            value = -SIDE_OTHER_INSTANCE(negamax, side)(ctx, searchDepth - 1, -beta, -alpha);
+        }
+        else {
+            value = -SIDE_OTHER_INSTANCE(negamax, side)(ctx, searchDepth - 1, -alpha - 1, -alpha);
+            if (value > alpha && value < beta && !ctx->aborted){
+                value = -SIDE_OTHER_INSTANCE(negamax, side)(ctx, searchDepth - 1, -beta, -alpha);
+            }
+        }
+
+        search_undo(ctx);
+
+        if (ctx->aborted){    /* the value is not real, never store it. */
+            return 0;
+        }
+
+        if (value > bestValue){
+            bestValue = value;
+            bestNode = node;
+
+            if (value > alpha && value < beta){
+                search_update_pv(ctx, &node);
+            }
+        }
+
+        alpha = COMPARE_MAX(alpha, bestValue);
+        if (alpha >= beta){
+            search_update_killers(ctx, &node);
+            break;
+        }
+    }
+
+    if (mirrored){
+        move_mirror(&bestNode, &bestNode);
+    }
+
+    /* 
+        a score from a repetition below only holds for this path, another path to the board may not repeat.
+        it is stored with depth 0, which never cuts a search off, the best move still helps the move order.
+    */
+    trans_table_store(ctx->tt, key, (ctx->repetitions == repetitionsBefore) ? searchDepth : 0, bestValue, alphaOrigin, betaOrigin, &bestNode);
+    return bestValue;
+}
+
+/* the search of each side, built at compile time from the functions above. */
+static int quiescence_up(struct SearchContext* ctx, int alpha, int beta){
+    return quiescence_side(ctx, alpha, beta, PS_UP);
+}
+
+static int quiescence_down(struct SearchContext* ctx, int alpha, int beta){
+    return quiescence_side(ctx, alpha, beta, PS_DOWN);
+}
+
+static int negamax_up(struct SearchContext* ctx, unsigned int searchDepth, int alpha, int beta){
+    return negamax_side(ctx, searchDepth, alpha, beta, PS_UP);
+}
+
+static int negamax_down(struct SearchContext* ctx, unsigned int searchDepth, int alpha, int beta){
+    return negamax_side(ctx, searchDepth, alpha, beta, PS_DOWN);
+}
+
+/* negamax of the side to move of ctx's board, for the callers outside the search tree. */
+static int negamax(struct SearchContext* ctx, unsigned int searchDepth, int alpha, int beta){
+    return SIDE_INSTANCE(negamax, ctx->board.side)(ctx, searchDepth, alpha, beta);
+}
+
+/* all moves of the root, in the order the move picker gives them, the previous best move first. return the number of moves. */
+static size_t search_root_moves(struct SearchContext* ctx, const struct MoveNode* bestMove, struct MoveNode* moves){
+    struct MovePicker picker;
+    size_t count = 0, i;
+
+    move_picker_init(&picker, bestMove);
+    while (count < MAX_ONE_SIDE_POSSIBLE_MOVES_LEN && move_picker_next(&picker, ctx, &(moves[count]))){
+        /* every root move once, or a Multi-PV line could search the move of a line before it again. */
+        for (i = 0; i < count; ++i){
+            if (move_is_same(&(moves[i]), &(moves[count]))){
+                break;
+            }
+        }
+
+        if (i == count){
+            ++count;
+        }
+    }
+
+    return count;
+}
+
+/* 
+    search the root moves first, first + step, first + 2 * step ... to the given depth in plies.
+    the best of them is written to bestMove and its score is returned, found is set if any move is searched to the end.
+    if bound is not NULL, it is the score of a move searched before, only a better move is found then.
+    unlike the search below it, bound and the score returned are scores of the board, down is positive.
+*/
+static int search_root(struct SearchContext* ctx, unsigned int depth, const struct MoveNode* moves, size_t count, size_t first, size_t step, 
+                       const int* bound, struct MoveNode* bestMove, int* found){
+    int sign = SIDE_SIGN(ctx->board.side);
+    const struct MoveNode* node;
+    int hasValue = (bound != NULL);
+    int bestValue = hasValue ? sign * *bound : -SCORE_INFINITE;
+    size_t i;
+    int value;
+
+    *found = 0;
+    ctx->pvLen[0] = 0;
+
+    for (i = first; i < count; i += step){
+        node = &(moves[i]);
+        search_move(ctx, node);
+        if (!hasValue || bestValue >= SCORE_INFINITE){
+            value = -negamax(ctx, depth - 1, -SCORE_INFINITE, -bestValue);
+        }
+        else {    /* null window first, search again only if it may be better. */
+            value = -negamax(ctx, depth - 1, -bestValue - 1, -bestValue);
+            if (value > bestValue && !ctx->aborted){
+                value = -negamax(ctx, depth - 1, -SCORE_INFINITE, -bestValue);
+            }
+        }
+
+        search_undo(ctx);
+
+        if (ctx->aborted){
+            if (!*found){    /* any move is better than none. */
+                memcpy(bestMove, node, sizeof(struct MoveNode));
+            }
+
+            break;
+        }
+
+        if (!hasValue || value > bestValue){
+            bestValue = value;
+            memcpy(bestMove, node, sizeof(struct MoveNode));
+            search_update_pv(ctx, node);
+            *found = 1;
+            hasValue = 1;
+        }
+    }
+
+    return sign * bestValue;
+}
+
+/* keep the result of a completed iteration, the principal variation is copied from pv, it may be ctx's own. */
+static void search_set_best_line(struct SearchContext* ctx, unsigned int depth, const struct MoveNode* pv, int pvLen){
+    memmove(ctx->bestLine, pv, pvLen * sizeof(struct MoveNode));
+    ctx->bestLineLen = pvLen;
+    ctx->stats.depth = depth;
+}
+
+/* 
+    is the root move moves[0], scored value, better than all the others by TIME_DOMINANCE_MARGIN ?
+    the others are only proved worse by null window searches at a reduced depth.
+*/
+static int search_root_dominates(struct SearchContext* ctx, unsigned int depth, const struct MoveNode* moves, size_t count, int value){
+    int bound = SIDE_SIGN(ctx->board.side) * value - TIME_DOMINANCE_MARGIN;    /* from the view of the side to move. */
+    size_t i;
+    int score;
+
+    for (i = 1; i < count; ++i){
+        search_move(ctx, &(moves[i]));
+        score = -negamax(ctx, depth - 1, -bound - 1, -bound);
+        search_undo(ctx);
+
+        if (ctx->aborted || score >= bound){
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+/* 
+    called after every completed iteration of a search by the clock, return 1 if the search should stop now.
+    moves are the root moves of that iteration, bestMove and value its result.
+*/
+static int search_time_is_up(struct SearchContext* ctx, unsigned int depth, const struct MoveNode* moves, size_t count, const struct MoveNode* bestMove, int value){
+    struct TimeManager* tm = &(ctx->timer);
+
+    if (!tm->active){
+        return 0;
+    }
+
+    if (count <= 1){    /* nothing to think about. */
+        return 1;
+    }
+
+    if (depth > 1){
+        int drop = (ctx->board.side == PS_DOWN) ? tm->lastValue - value : value - tm->lastValue;
+
+        if (!move_is_same(bestMove, &(tm->lastMove))){
+            tm->scale += TIME_MOVE_CHANGE_PERCENT;
+            tm->stable = 0;
+        }
+        else {
+            ++(tm->stable);
+        }
+
+        if (drop >= TIME_SCORE_DROP){
+            tm->scale += TIME_SCORE_DROP_PERCENT;
+        }
+
+        tm->scale = COMPARE_MIN(tm->scale, TIME_MAX_SCALE);
+    }
+
+    memcpy(&(tm->lastMove), bestMove, sizeof(struct MoveNode));
+    tm->lastValue = value;
+
+    long long budget = tm->softMs * tm->scale / 100;
+    if (time_now_ms() - tm->start >= COMPARE_MIN(budget * TIME_NEXT_ITERATION_PERCENT / 100, tm->hardMs)){
+        return 1;
+    }
+
+    /* a won or lost general is not worth a dominance check. */
+    if (tm->stable >= TIME_DOMINANCE_STABLE && depth >= TIME_DOMINANCE_MIN_DEPTH && abs(value) < piece_get_value[P_DG] / 2 &&
+        move_is_same(&(moves[0]), bestMove)){
+        return search_root_dominates(ctx, depth - TIME_DOMINANCE_REDUCTION, moves, count, value);
+    }
+
+    return 0;
+}
+
+/* 
+    gen best move for the side to move of ctx's board, return its score.
+    searchDepth is used as difficulty rank, the bigger it is, the more time the generation costs.
+    iterative deepening is used, so the transposition table always has a best move to try first.
+    if a limit of ctx stops the search, the result of the last completed iteration is returned,
+    or the best move found so far if not even the first one is done.
+    the principal variation is left in ctx->bestLine.
+    if there is no move at all, bestMove is {0, 0, 0, 0}.
+*/
+static int board_gen_best_move(struct SearchContext* ctx, unsigned int searchDepth, struct MoveNode* bestMove){
+    assert(ctx != NULL && bestMove != NULL);
+
+    struct MoveNode moves[MAX_ONE_SIDE_POSSIBLE_MOVES_LEN];
+    struct MoveNode iterationMove;
+    unsigned int depth;
+    size_t count;
+    int value = 0, iterationValue, found;
+    memset(bestMove, 0, sizeof(struct MoveNode));
+    memset(&iterationMove, 0, sizeof(struct MoveNode));
+    ctx->bestLineLen = 0;
+
+    for (depth = 1; depth <= searchDepth + 1; ++depth){
+        count = search_root_moves(ctx, bestMove, moves);
+        iterationValue = search_root(ctx, depth, moves, count, 0, 1, NULL, &iterationMove, &found);
+
+        if (ctx->aborted){
+            if (depth == 1 && count > 0){
+                memcpy(bestMove, &iterationMove, sizeof(struct MoveNode));
+                search_set_best_line(ctx, 0, bestMove, 1);
+            }
+
+            break;
+        }
+
+        if (found){
+            memcpy(bestMove, &iterationMove, sizeof(struct MoveNode));
+            value = iterationValue;
+            search_set_best_line(ctx, depth, ctx->pv[0], ctx->pvLen[0]);
+        }
+
+        if (search_time_is_up(ctx, depth, moves, count, bestMove, value)){
+            break;
+        }
+    }
+
+    return value;
+}
+
+/* 
+    a line is cut short where the search took a score from the transposition table,
+    make it up to maxLen moves long by following the moves of exact entries.
+*/
+static void search_extend_line(struct SearchContext* ctx, struct SearchLine* line, int maxLen){
+    struct ChessBoard* cb = &(ctx->board);
+    struct TransEntry entry;
+    struct MoveNode move;
+    unsigned long long key;
+    int i, played = 0, mirrored;
+
+    maxLen = COMPARE_MIN(maxLen, MAX_SEARCH_PLY);
+    for (i = 0; i < line->len; ++i){
+        search_move(ctx, &(line->moves[i]));
+        ++played;
+    }
+
+    while (line->len < maxLen){
+        mirrored = 0;
+        key = (ctx->ply <= SEARCH_MIRROR_MAX_PLY) ? board_canonical_hash(cb, &mirrored) : cb->hash;
+        if (!trans_table_probe(ctx->tt, key, &entry) || entry.bound != TB_EXACT){
+            break;
+        }
+
+        if (mirrored){
+            move_mirror(&(entry.move), &move);
+        }
+        else {
+            memcpy(&move, &(entry.move), sizeof(struct MoveNode));
+        }
+
+        if (!board_is_pseudo_legal(cb, &move)){
+            break;
+        }
+
+        memcpy(&(line->moves[line->len]), &move, sizeof(struct MoveNode));
+        ++(line->len);
+        search_move(ctx, &move);
+        ++played;
+    }
+
+    while (played-- > 0){
+        search_undo(ctx);
+    }
+}
+
+/* move the root move to moves[index], the moves from index on keep their order otherwise. */
+static void search_root_move_to(struct MoveNode* moves, size_t count, const struct MoveNode* move, size_t index){
+    struct MoveNode saved;
+    size_t i;
+
+    for (i = index; i < count; ++i){
+        if (move_is_same(&(moves[i]), move)){
+            memcpy(&saved, &(moves[i]), sizeof(struct MoveNode));
+            memmove(&(moves[index + 1]), &(moves[index]), (i - index) * sizeof(struct MoveNode));
+            memcpy(&(moves[index]), &saved, sizeof(struct MoveNode));
+            return;
+        }
+    }
+}
+
+/* 
+    Multi-PV: search the lineCount best moves for the side to move of ctx's board, best first, return how many were found.
+    every iteration searches the root once for each line, without the moves of the lines before it, so every score is exact.
+    all the lines share the transposition table, and the lines of the last iteration are searched first in the next one.
+    like board_gen_best_move(), a search stopped by a limit returns the lines of the last completed iteration,
+    the best line is left in ctx->bestLine too. return 0 if out of memory.
+*/
+static size_t board_gen_best_lines(struct SearchContext* ctx, unsigned int searchDepth, struct SearchLine* lines, size_t lineCount){
+    assert(ctx != NULL && lines != NULL && lineCount > 0);
+
+    struct MoveNode moves[MAX_ONE_SIDE_POSSIBLE_MOVES_LEN];
+    struct SearchLine* iteration = (struct SearchLine*)malloc(lineCount * sizeof(struct SearchLine));
+    struct MoveNode move;
+    unsigned int depth;
+    size_t count, wanted, found = 0, k;
+    int value, ok;
+
+    ctx->bestLineLen = 0;
+    if (iteration == NULL){
+        return 0;
+    }
+
+    for (depth = 1; depth <= searchDepth + 1; ++depth){
+        count = search_root_moves(ctx, (found > 0) ? &(lines[0].moves[0]) : NULL, moves);
+        for (k = 0; k < found; ++k){
+            search_root_move_to(moves, count, &(lines[k].moves[0]), k);
+        }
+
+        wanted = COMPARE_MIN(lineCount, count);
+        for (k = 0; k < wanted; ++k){
+            value = search_root(ctx, depth, moves, count, k, 1, NULL, &move, &ok);
+            if (ctx->aborted || !ok){
+                break;
+            }
+
+            search_root_move_to(moves, count, &move, k);
+            memcpy(iteration[k].moves, ctx->pv[0], ctx->pvLen[0] * sizeof(struct MoveNode));
+            iteration[k].len = ctx->pvLen[0];
+            iteration[k].value = value;
+        }
+
+        if (k < wanted){
+            if (found == 0 && k > 0){    /* the lines done of the first iteration are better than none. */
+                memcpy(lines, iteration, k * sizeof(struct SearchLine));
+                found = k;
+            }
+            else if (found == 0 && count > 0){
+                memcpy(&(lines[0].moves[0]), &(moves[0]), sizeof(struct MoveNode));
+                lines[0].len = 1;
+                lines[0].value = 0;
+                found = 1;
+            }
+
+            if (found > 0 && ctx->bestLineLen == 0){
+                search_set_best_line(ctx, 0, lines[0].moves, lines[0].len);
+            }
+
+            break;
+        }
+
+        for (k = 0; k < wanted; ++k){
+            search_extend_line(ctx, &(iteration[k]), (int)depth);
+        }
+
+        memcpy(lines, iteration, wanted * sizeof(struct SearchLine));
+        found = wanted;
+        if (found == 0){
+            break;
+        }
+
+        search_set_best_line(ctx, depth, lines[0].moves, lines[0].len);
+        if (search_time_is_up(ctx, depth, moves, count, &(lines[0].moves[0]), lines[0].value)){
+            break;
+        }
+    }
+
+    free(iteration);
+    return found;
+}
+
+/* 
+    a worker of the deterministic multithreaded search. every worker has its own transposition table
+    and node limit, and searches a fixed share of the root moves, so nothing depends on thread timing.
+*/
+struct SplitWorker{
+    struct SearchContext ctx;
+    pthread_t thread;
+    int started;                 /* the thread was made, else the calling thread searches this share. */
+    const struct MoveNode* moves;
+    size_t count;
+    size_t first;
+    size_t step;
+    unsigned int depth;
+    const int* bound;
+    struct MoveNode best;
+    int value;
+    int found;
+};
+
+static void* split_worker_run(void* arg){
+    struct SplitWorker* worker = (struct SplitWorker*)arg;
+    worker->value = search_root(&(worker->ctx), worker->depth, worker->moves, worker->count, worker->first, worker->step, 
+                                worker->bound, &(worker->best), &(worker->found));
+    return NULL;
+}
+
+/* index of a move in the root moves. */
+static size_t split_move_index(const struct MoveNode* moves, size_t count, const struct MoveNode* move){
+    size_t i;
+    for (i = 0; i < count; ++i){
+        if (move_is_same(&(moves[i]), move)){
+            break;
+        }
+    }
+
+    return i;
+}
+
+/*
+    board_gen_best_move() on threads workers, the same result every run for the same position and limits.
+    in every iteration worker 0 searches the first root move alone, then the other moves are dealt to the workers
+    like cards, worker i gets moves 1 + i, 1 + i + threads, ... and only has to prove them better than the first one.
+    a tie between workers goes to the move earlier in the root move order.
+    the node limit of ctx is split evenly, time and stop limits still work but are not deterministic.
+    every worker gets a transposition table of ttSizeInMB / threads, ctx's own table is not used, ctx's evaluation cache is shared.
+    if the workers can't be made, ctx searches alone with board_gen_best_move().
+*/
+static int board_gen_best_move_split(struct SearchContext* ctx, unsigned int searchDepth, unsigned int threads, size_t ttSizeInMB, struct MoveNode* bestMove){
+    assert(ctx != NULL && bestMove != NULL && threads > 0);
+
+    struct SplitWorker* workers = (struct SplitWorker*)malloc(threads * sizeof(struct SplitWorker));
+    struct TransTable* tt;
+    struct MoveNode moves[MAX_ONE_SIDE_POSSIBLE_MOVES_LEN];
+    struct MoveNode firstLine[MAX_SEARCH_PLY];
+    struct MoveNode iterationMove;
+    const struct MoveNode* line;
+    unsigned int depth, i;
+    size_t count, bestIndex, index;
+    int value = 0, iterationValue, lineLen, found;
+    int aborted = 0;
+
+    for (i = 0; workers != NULL && i < threads; ++i){
+        tt = trans_table_make_new(COMPARE_MAX(ttSizeInMB / threads, 1), 0);
+        if (tt == NULL){
+            while (i-- > 0){
+                trans_table_free(workers[i].ctx.tt);
+            }
+
+            free(workers);
+            workers = NULL;
+            break;
+        }
+
+        search_context_init(&(workers[i].ctx), &(ctx->board), ctx->record, tt);
+        workers[i].ctx.evalCache = ctx->evalCache;
+        workers[i].ctx.params = ctx->params;
+        workers[i].ctx.nodeLimit = (ctx->nodeLimit == 0) ? 0 : COMPARE_MAX(ctx->nodeLimit / threads + (i < ctx->nodeLimit % threads), 1);
+        workers[i].ctx.deadline = ctx->deadline;
+        workers[i].ctx.stop = ctx->stop;
+    }
+
+    if (workers == NULL){
+        return board_gen_best_move(ctx, searchDepth, bestMove);
+    }
+
+    memset(bestMove, 0, sizeof(struct MoveNode));
+    ctx->bestLineLen = 0;
+
+    for (depth = 1; depth <= searchDepth + 1; ++depth){
+        count = search_root_moves(ctx, bestMove, moves);
+        if (count == 0){
+            break;
+        }
+
+        /* the first move, the best one of the last iteration, alone. */
+        iterationValue = search_root(&(workers[0].ctx), depth, moves, 1, 0, 1, NULL, &iterationMove, &found);
+        if (workers[0].ctx.aborted){
+            aborted = 1;
+        }
+        else {
+            lineLen = workers[0].ctx.pvLen[0];
+            memcpy(firstLine, workers[0].ctx.pv[0], lineLen * sizeof(struct MoveNode));
+            line = firstLine;
+            bestIndex = 0;
+
+            for (i = 0; i < threads; ++i){
+                workers[i].moves = moves;
+                workers[i].count = count;
+                workers[i].first = 1 + i;
+                workers[i].step = threads;
+                workers[i].depth = depth;
+                workers[i].bound = &iterationValue;
+                workers[i].started = pthread_create(&(workers[i].thread), NULL, split_worker_run, &(workers[i])) == 0;
+            }
+
+            /* the shares are fixed, so a share without a thread gives the same result here. */
+            for (i = 0; i < threads; ++i){
+                if (!workers[i].started){
+                    split_worker_run(&(workers[i]));
+                }
+            }
+
+            for (i = 0; i < threads; ++i){
+                if (workers[i].started){
+                    pthread_join(workers[i].thread, NULL);
+                }
+
+                aborted |= workers[i].ctx.aborted;
+            }
+
+            for (i = 0; !aborted && i < threads; ++i){
+                if (!workers[i].found){
+                    continue;
+                }
+
+                index = split_move_index(moves, count, &(workers[i].best));
+                if (workers[i].value == iterationValue ? index < bestIndex :
+                    ((ctx->board.side == PS_DOWN) ? workers[i].value > iterationValue : workers[i].value < iterationValue)){
+                    iterationValue = workers[i].value;
+                    memcpy(&iterationMove, &(workers[i].best), sizeof(struct MoveNode));
+                    line = workers[i].ctx.pv[0];
+                    lineLen = workers[i].ctx.pvLen[0];
+                    bestIndex = index;
+                }
+            }
+        }
+
+        if (aborted){
+            if (depth == 1){    /* take the first root move, like board_gen_best_move() would. */
+                memcpy(bestMove, &(moves[0]), sizeof(struct MoveNode));
+                search_set_best_line(ctx, 0, bestMove, 1);
+            }
+
+            break;
+        }
+
+        memcpy(bestMove, &iterationMove, sizeof(struct MoveNode));
+        value = iterationValue;
+        search_set_best_line(ctx, depth, line, lineLen);
+
+        if (search_time_is_up(ctx, depth, moves, count, bestMove, value)){
+            break;
+        }
+    }
+
+    for (i = 0; i < threads; ++i){
+        ctx->stats.nodes += workers[i].ctx.stats.nodes;
+        ctx->stats.generatedMoves += workers[i].ctx.stats.generatedMoves;
+        ctx->stats.ttProbes += workers[i].ctx.stats.ttProbes;
+        ctx->stats.ttHits += workers[i].ctx.stats.ttHits;
+        ctx->stats.evals += workers[i].ctx.stats.evals;
+        ctx->stats.evalLazy += workers[i].ctx.stats.evalLazy;
+        ctx->stats.evalCacheProbes += workers[i].ctx.stats.evalCacheProbes;
+        ctx->stats.evalCacheHits += workers[i].ctx.stats.evalCacheHits;
+        ctx->stats.evalTimeNs += workers[i].ctx.stats.evalTimeNs;
+        trans_table_free(workers[i].ctx.tt);
+    }
+
+    ctx->aborted = aborted;
+    free(workers);
+    return value;
+}
+
+/* user input could represent a move ? return 0 if can't. */
+static int check_input_is_a_move(char* input, size_t len){
+    assert(input != NULL);
+
+    if (len < 4){
+        return 0;
+    }
+
+    return  (input[0] >= 'a' && input[0] <= 'i') &&
+            (input[1] >= '0' && input[1] <= '9') &&
+            (input[2] >= 'a' && input[2] <= 'i') &&
+            (input[3] >= '0' && input[3] <= '9');
+}
+
+/*
+    convert user input to a struct MoveNode object.
+    you should call check_input_is_a_move() before to make sure this converting is valid.
+*/
+static void convert_input_to_move(char* input, struct MoveNode* move){
+    assert(input != NULL && move != NULL);
+
+    move->beginRow = 9 - ((int)input[1] - (int)'0') + BOARD_ACTUAL_ROW_BEGIN;
+    move->beginCol = (int)input[0] - (int)'a' + BOARD_ACTUAL_COL_BEGIN;
+    move->endRow = 9 - ((int)input[3] - (int)'0') + BOARD_ACTUAL_ROW_BEGIN;
+    move->endCol = (int)input[2] - (int)'a' + BOARD_ACTUAL_COL_BEGIN;
+}
+
+/* 
+    convert a move to string. 
+    len must be bigger or equal to MOVE_TO_STR_BUFFER_LEN, otherwise this function returns 0.
+*/
+static int convert_move_to_str(const struct MoveNode* move, char* buf, size_t len){
+    assert(move != NULL && buf != NULL);
+
+    if (len < MOVE_TO_STR_BUFFER_LEN){
+        return 0;
+    }
+
+    buf[0] = move->beginCol - BOARD_ACTUAL_COL_BEGIN + 'a';
+    buf[1] = 9 - (move->beginRow - BOARD_ACTUAL_ROW_BEGIN) + '0';
+    buf[2] = move->endCol - BOARD_ACTUAL_COL_BEGIN + 'a';
+    buf[3] = 9 - (move->endRow - BOARD_ACTUAL_ROW_BEGIN) + '0';
+    buf[4] = '\0';
+    return 1;
+}
+
+/* opening book lines, every one is the moves played from the default board. */
+static const char* OPENING_BOOK_LINES[] = {
+    #include "chessBoardOpeningBook.txt"
+};
+
+static int book_entry_compare(const void* left, const void* right){
+    const struct BookEntry* l = (const struct BookEntry*)left;
+    const struct BookEntry* r = (const struct BookEntry*)right;
+
+    if (l->key != r->key){
+        return (l->key < r->key) ? -1 : 1;
+    }
+
+    return memcmp(&(l->move), &(r->move), sizeof(struct MoveNode));
+}
+
+/* 
+    play every book line and keep its moves by board_canonical_hash(), the same move met again is counted.
+    a line is cut at the first move not fit for the rules.
+*/
+static void opening_book_init(void){
+    struct ChessBoard cb;
+    struct HistoryNode hist;
+    struct MoveNode move;
+    size_t i, merged;
+    int mirrored;
+
+    opening_book_len = 0;
+
+    for (i = 0; i < sizeof(OPENING_BOOK_LINES) / sizeof(OPENING_BOOK_LINES[0]); ++i){
+        const char* cursor = OPENING_BOOK_LINES[i];
+        board_init(&cb);
+
+        while (*cursor != '\0' && opening_book_len < OPENING_BOOK_MAX_ENTRIES){
+            if (!check_input_is_a_move((char*)cursor, strlen(cursor))){
+                break;
+            }
+
+            convert_input_to_move((char*)cursor, &move);
+            if (!board_is_pseudo_legal(&cb, &move)){
+                break;
+            }
+
+            struct BookEntry* entry = &(opening_book[opening_book_len++]);
+            entry->key = board_canonical_hash(&cb, &mirrored);
+            entry->count = 1;
+            if (mirrored){
+                move_mirror(&move, &(entry->move));
+            }
+            else {
+                memcpy(&(entry->move), &move, sizeof(struct MoveNode));
+            }
+
+            board_move(&cb, &move, &hist);
+            cursor += 4;
+            while (*cursor == ' '){
+                ++cursor;
+            }
+        }
+    }
+
+    qsort(opening_book, opening_book_len, sizeof(struct BookEntry), book_entry_compare);
+
+    for (i = 0, merged = 0; i < opening_book_len; ++i){
+        if (merged > 0 && book_entry_compare(&(opening_book[merged - 1]), &(opening_book[i])) == 0){
+            opening_book[merged - 1].count += opening_book[i].count;
+        }
+        else {
+            memcpy(&(opening_book[merged++]), &(opening_book[i]), sizeof(struct BookEntry));
+        }
+    }
+
+    opening_book_len = merged;
+}
+
+/* 
+    the book move for cb, the one played by most book lines, mirrored positions are found too.
+    return 0 if cb is not in the book.
+*/
+static int opening_book_probe(struct ChessBoard* cb, struct MoveNode* move){
+    assert(cb != NULL && move != NULL);
+
+    int mirrored;
+    unsigned long long key = board_canonical_hash(cb, &mirrored);
+    size_t low = 0, high = opening_book_len, i;
+    const struct BookEntry* best = NULL;
+
+    while (low < high){
+        size_t mid = low + (high - low) / 2;
+        if (opening_book[mid].key < key){
+            low = mid + 1;
+        }
+        else {
+            high = mid;
+        }
+    }
+
+    for (i = low; i < opening_book_len && opening_book[i].key == key; ++i){
+        if (best == NULL || opening_book[i].count > best->count){
+            best = &(opening_book[i]);
+        }
+    }
+
+    if (best == NULL){
+        return 0;
+    }
+
+    if (mirrored){
+        move_mirror(&(best->move), move);
+    }
+    else {
+        memcpy(move, &(best->move), sizeof(struct MoveNode));
+    }
+
+    return board_is_pseudo_legal(cb, move);
+}
+
+/* search depth of the game, also used by the library when no depth is given. */
+#define CNCHESS_AI_SEARCH_DEPTH 4
+
+/* FEN letters of every piece, upper case is the down side. */
+static const char piece_get_fen_char[] = {
+    'p', 'c', 'r', 'n', 'b', 'a', 'k',
+    'P', 'C', 'R', 'N', 'B', 'A', 'K'
+};
+
+/* 
+    set a board from the piece placement and the side to move of a FEN, the other fields are ignored.
+    'h' and 'e' are taken for knight and bishop too, 'g' for general. return 0 if fen is invalid, cb is not changed then.
+*/
+static int board_set_fen(struct ChessBoard* cb, const char* fen){
+    assert(cb != NULL && fen != NULL);
+
+    static const char aliases[][2] = { { 'h', 'n' }, { 'e', 'b' }, { 'g', 'k' } };
+    struct ChessBoard tmp;
+    int generals[2] = { 0, 0 };
+    int r = BOARD_ACTUAL_ROW_BEGIN, c = BOARD_ACTUAL_COL_BEGIN;
+    size_t i;
+
+    memcpy(tmp.data, &CHESS_BOARD_DEFAULT_TEMPLATE, sizeof(tmp.data));
+    for (r = BOARD_ACTUAL_ROW_BEGIN; r < BOARD_ACTUAL_ROW_BEGIN + BOARD_ACTUAL_ROW_LEN; ++r){
+        for (c = BOARD_ACTUAL_COL_BEGIN; c < BOARD_ACTUAL_COL_BEGIN + BOARD_ACTUAL_COL_LEN; ++c){
+            tmp.data[r][c] = P_EE;
+        }
+    }
+
+    r = BOARD_ACTUAL_ROW_BEGIN;
+    c = BOARD_ACTUAL_COL_BEGIN;
+
+    for (; *fen != '\0' && *fen != ' '; ++fen){
+        if (*fen == '/'){
+            if (c != BOARD_ACTUAL_COL_BEGIN + BOARD_ACTUAL_COL_LEN){
+                return 0;
+            }
+
+            ++r;
+            c = BOARD_ACTUAL_COL_BEGIN;
+            if (r >= BOARD_ACTUAL_ROW_BEGIN + BOARD_ACTUAL_ROW_LEN){
+                return 0;
+            }
+        }
+        else if (*fen >= '1' && *fen <= '9'){
+            c += *fen - '0';
+            if (c > BOARD_ACTUAL_COL_BEGIN + BOARD_ACTUAL_COL_LEN){
+                return 0;
+            }
+        }
+        else {
+            char lower = (*fen >= 'A' && *fen <= 'Z') ? *fen - 'A' + 'a' : *fen;
+            enum Piece p;
+
+            for (i = 0; i < sizeof(aliases) / sizeof(aliases[0]); ++i){
+                if (lower == aliases[i][0]){
+                    lower = aliases[i][1];
+                }
+            }
+
+            for (p = P_UP; p <= P_UG; ++p){
+                if (piece_get_fen_char[p] == lower){
+                    break;
+                }
+            }
+
+            if (p > P_UG || c >= BOARD_ACTUAL_COL_BEGIN + BOARD_ACTUAL_COL_LEN){
+                return 0;
+            }
+
+            if (*fen >= 'A' && *fen <= 'Z'){
+                p += P_DP - P_UP;
+            }
+
+            if (piece_get_type[p] == PT_GENERAL){
+                if (!board_in_palace(r, c, piece_get_side[p])){
+                    return 0;
+                }
+
+                ++generals[piece_get_side[p]];
+            }
+
+            tmp.data[r][c++] = p;
+        }
+    }
+
+    if (r != BOARD_ACTUAL_ROW_BEGIN + BOARD_ACTUAL_ROW_LEN - 1 || c != BOARD_ACTUAL_COL_BEGIN + BOARD_ACTUAL_COL_LEN ||
+        generals[PS_UP] != 1 || generals[PS_DOWN] != 1){
+        return 0;
+    }
+
+    while (*fen == ' '){
+        ++fen;
+    }
+
+    if (*fen == 'w' || *fen == 'r' || *fen == '\0'){
+        tmp.side = PS_DOWN;
+    }
+    else if (*fen == 'b'){
+        tmp.side = PS_UP;
+    }
+    else {
+        return 0;
+    }
+
+    tmp.hash = board_calc_hash(&tmp);
+    tmp.mirrorHash = board_calc_mirror_hash(&tmp);
+    tmp.score = board_calc_score(&tmp);
+    memcpy(cb, &tmp, sizeof(struct ChessBoard));
+    return 1;
+}
+
+/* append the moves of the side to move which don't leave its own general attacked. */
+static void board_gen_legal_moves(struct ChessBoard* cb, struct PossibleMoves* pm){
+    assert(cb != NULL && pm != NULL);
+
+    struct PossibleMoves pseudo;
+    struct HistoryNode hist;
+    enum PieceSide side = cb->side;
+    size_t i;
+
+    pseudo.len = 0;
+    board_gen_possible_moves(cb, side, GEN_ALL, &pseudo);
+
+    for (i = 0; i < pseudo.len; ++i){
+        board_move(cb, &(pseudo.data[i]), &hist);
+        if (!board_is_in_check(cb, side)){
+            memcpy(&(pm->data[pm->len++]), &(pseudo.data[i]), sizeof(struct MoveNode));
+        }
+
+        board_undo(cb, &hist);
+    }
+}
+
+#define RECORD_BINARY_MAGIC "CNCR"
+#define RECORD_BINARY_VERSION 1
+#define RECORD_BINARY_HEADER_LEN 5
+
+static const char* RECORD_RESULT_STR[] = { "*", "1-0", "0-1", "1/2-1/2" };
+
+/* files whose name ends with ".bin" use the binary format. */
+static int record_path_is_binary(const char* path){
+    size_t len = strlen(path);
+    return len >= 4 && strcmp(path + len - 4, ".bin") == 0;
+}
+
+/* square index 0 - 89 of a board position, used by the binary format. */
+static unsigned int record_pack_move(const struct MoveNode* move){
+    unsigned int begin = (move->beginRow - BOARD_ACTUAL_ROW_BEGIN) * BOARD_ACTUAL_COL_LEN + (move->beginCol - BOARD_ACTUAL_COL_BEGIN);
+    unsigned int end = (move->endRow - BOARD_ACTUAL_ROW_BEGIN) * BOARD_ACTUAL_COL_LEN + (move->endCol - BOARD_ACTUAL_COL_BEGIN);
+    return begin | (end << 7);
+}
+
+/* return 0 if the packed move has a square out of the board. */
+static int record_unpack_move(unsigned int packed, struct MoveNode* move){
+    unsigned int begin = packed & 0x7F, end = (packed >> 7) & 0x7F;
+
+    if (begin >= BOARD_ACTUAL_ROW_LEN * BOARD_ACTUAL_COL_LEN || end >= BOARD_ACTUAL_ROW_LEN * BOARD_ACTUAL_COL_LEN){
+        return 0;
+    }
+
+    move->beginRow = begin / BOARD_ACTUAL_COL_LEN + BOARD_ACTUAL_ROW_BEGIN;
+    move->beginCol = begin % BOARD_ACTUAL_COL_LEN + BOARD_ACTUAL_COL_BEGIN;
+    move->endRow = end / BOARD_ACTUAL_COL_LEN + BOARD_ACTUAL_ROW_BEGIN;
+    move->endCol = end % BOARD_ACTUAL_COL_LEN + BOARD_ACTUAL_COL_BEGIN;
+    return 1;
+}
+
+/* 
+    open a record file for appending, the format is chosen by record_path_is_binary().
+    return 0 if failed, or if the file is a binary record of another version, errno is EINVAL then.
+*/
+static int record_writer_open(struct RecordWriter* writer, const char* path){
+    assert(writer != NULL && path != NULL);
+
+    unsigned char header[RECORD_BINARY_HEADER_LEN];
+
+    writer->binary = record_path_is_binary(path);
+    writer->fp = fopen(path, writer->binary ? "a+b" : "a");
+    if (writer->fp == NULL){
+        return 0;
+    }
+
+    if (writer->binary){
+        fseek(writer->fp, 0, SEEK_END);
+        if (ftell(writer->fp) == 0){    /* a new binary file needs the header first. */
+            fwrite(RECORD_BINARY_MAGIC, 1, 4, writer->fp);
+            fputc(RECORD_BINARY_VERSION, writer->fp);
+        }
+        else {    /* appending reads the header, the games written go to the end anyway. */
+            rewind(writer->fp);
+            if (fread(header, 1, RECORD_BINARY_HEADER_LEN, writer->fp) != RECORD_BINARY_HEADER_LEN ||
+                memcmp(header, RECORD_BINARY_MAGIC, 4) != 0 || header[4] != RECORD_BINARY_VERSION){
+                fclose(writer->fp);
+                writer->fp = NULL;
+                errno = EINVAL;
+                return 0;
+            }
+        }
+    }
+
+    return 1;
+}
+
+static void record_writer_close(struct RecordWriter* writer){
+    if (writer != NULL && writer->fp != NULL){
+        fclose(writer->fp);
+        writer->fp = NULL;
+    }
+}
+
+/* append one game, the moves come from a struct GameRecord or any array of moves. */
+static void record_writer_write_moves(struct RecordWriter* writer, const struct MoveNode* moves, size_t stride, size_t len, enum RecordResult result){
+    assert(writer != NULL && writer->fp != NULL);
+
+    const unsigned char* cursor = (const unsigned char*)moves;
+    char moveStr[MOVE_TO_STR_BUFFER_LEN];
+    size_t i;
+
+    if (writer->binary){
+        len = COMPARE_MIN(len, 0xFFFF);
+        fputc((int)(len & 0xFF), writer->fp);
+        fputc((int)(len >> 8), writer->fp);
+        fputc((int)result, writer->fp);
+
+        for (i = 0; i < len; ++i, cursor += stride){
+            unsigned int packed = record_pack_move((const struct MoveNode*)cursor);
+            fputc((int)(packed & 0xFF), writer->fp);
+            fputc((int)(packed >> 8), writer->fp);
+        }
+    }
+    else {
+        for (i = 0; i < len; ++i, cursor += stride){
+            convert_move_to_str((const struct MoveNode*)cursor, moveStr, MOVE_TO_STR_BUFFER_LEN);
+            fputs(moveStr, writer->fp);
+            fputc(' ', writer->fp);
+        }
+
+        fputs(RECORD_RESULT_STR[result], writer->fp);
+        fputc('\n', writer->fp);
+    }
+
+    fflush(writer->fp);
+}
+
+static void record_writer_write_game(struct RecordWriter* writer, const struct GameRecord* rec, enum RecordResult result){
+    assert(rec != NULL);
+    record_writer_write_moves(writer, &(rec->history[0].move), sizeof(struct HistoryNode), rec->length, result);
+}
+
+/* map a record file into memory. return 0 if failed, or if it is a binary record of another version, errno is EINVAL then. */
+static int record_reader_open(struct RecordReader* reader, const char* path){
+    assert(reader != NULL && path != NULL);
+
+    struct stat st;
+    int fd = open(path, O_RDONLY);
+    if (fd < 0){
+        return 0;
+    }
+
+    if (fstat(fd, &st) != 0){
+        close(fd);
+        return 0;
+    }
+
+    reader->data = NULL;
+    reader->size = (size_t)st.st_size;
+    reader->pos = 0;
+
+    if (reader->size > 0){
+        void* mapped = mmap(NULL, reader->size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapped == MAP_FAILED){
+            close(fd);
+            return 0;
+        }
+
+        posix_madvise(mapped, reader->size, POSIX_MADV_SEQUENTIAL);
+        reader->data = (const unsigned char*)mapped;
+    }
+
+    close(fd);
+
+    reader->binary = reader->size >= RECORD_BINARY_HEADER_LEN && memcmp(reader->data, RECORD_BINARY_MAGIC, 4) == 0;
+    if (reader->binary){
+        if (reader->data[4] != RECORD_BINARY_VERSION){
+            munmap((void*)reader->data, reader->size);
+            reader->data = NULL;
+            errno = EINVAL;
+            return 0;
+        }
+
+        reader->pos = RECORD_BINARY_HEADER_LEN;
+    }
+
+    return 1;
+}
+
+static void record_reader_close(struct RecordReader* reader){
+    if (reader != NULL && reader->data != NULL){
+        munmap((void*)reader->data, reader->size);
+        reader->data = NULL;
+    }
+}
+
+/* parse one ICCS move at text, like "h2e2" or "H2-E2", return the number of characters used, 0 if it is not a move. */
+static size_t record_parse_iccs(const unsigned char* text, size_t len, struct MoveNode* move){
+    char buf[4];
+    size_t used = 0;
+    int i;
+
+    for (i = 0; i < 4; ++i){
+        if (i == 2 && used < len && text[used] == '-'){
+            ++used;
+        }
+
+        if (used >= len){
+            return 0;
+        }
+
+        buf[i] = (char)text[used++];
+        if (i % 2 == 0 && buf[i] >= 'A' && buf[i] <= 'I'){
+            buf[i] = buf[i] - 'A' + 'a';
+        }
+    }
+
+    if (!((buf[0] >= 'a' && buf[0] <= 'i') && (buf[1] >= '0' && buf[1] <= '9') && (buf[2] >= 'a' && buf[2] <= 'i') && (buf[3] >= '0' && buf[3] <= '9'))){
+        return 0;
+    }
+
+    convert_input_to_move(buf, move);
+    return used;
+}
+
+/*
+    read the next game into moves, which has room for capacity moves.
+    return 1 if a game is read, 0 at the end of the file, -1 if the game is broken or too long, it is skipped then.
+*/
+static int record_reader_next_game(struct RecordReader* reader, struct MoveNode* moves, size_t capacity, size_t* len, enum RecordResult* result){
+    assert(reader != NULL && moves != NULL && len != NULL && result != NULL);
+
+    const unsigned char* data = reader->data;
+    size_t size = reader->size;
+    size_t pos = reader->pos;
+    size_t count = 0, i;
+
+    *len = 0;
+    *result = RR_UNKNOWN;
+
+    if (reader->binary){
+        if (pos + 3 > size){
+            return 0;
+        }
+
+        count = (size_t)data[pos] | ((size_t)data[pos + 1] << 8);
+        *result = (data[pos + 2] <= RR_DRAW) ? (enum RecordResult)data[pos + 2] : RR_UNKNOWN;
+        pos += 3;
+
+        if (pos + count * 2 > size){
+            reader->pos = size;
+            return -1;
+        }
+
+        reader->pos = pos + count * 2;
+        if (count > capacity){
+            return -1;
+        }
+
+        for (i = 0; i < count; ++i, pos += 2){
+            if (!record_unpack_move((unsigned int)data[pos] | ((unsigned int)data[pos + 1] << 8), &(moves[i]))){
+                return -1;
+            }
+        }
+
+        *len = count;
+        return 1;
+    }
+
+    /* text, skip empty lines first, they are not counted as games. */
+    while (pos < size && (data[pos] == '\n' || data[pos] == '\r')){
+        ++pos;
+    }
+
+    if (pos >= size){
+        reader->pos = pos;
+        return 0;
+    }
+
+    int broken = 0;
+    while (pos < size && data[pos] != '\n'){
+        if (data[pos] == ' ' || data[pos] == '\t' || data[pos] == '\r'){
+            ++pos;
+            continue;
+        }
+
+        size_t used = record_parse_iccs(data + pos, size - pos, &(moves[count]));
+        if (used > 0 && count < capacity){
+            ++count;
+            pos += used;
+            continue;
+        }
+
+        /* not a move, it should be the result. */
+        size_t tokenEnd = pos;
+        while (tokenEnd < size && data[tokenEnd] != ' ' && data[tokenEnd] != '\t' && data[tokenEnd] != '\r' && data[tokenEnd] != '\n'){
+            ++tokenEnd;
+        }
+
+        broken = 1;
+        for (i = 0; i < sizeof(RECORD_RESULT_STR) / sizeof(RECORD_RESULT_STR[0]); ++i){
+            if (strlen(RECORD_RESULT_STR[i]) == tokenEnd - pos && memcmp(data + pos, RECORD_RESULT_STR[i], tokenEnd - pos) == 0){
+                *result = (enum RecordResult)i;
+                broken = 0;
+            }
+        }
+
+        pos = tokenEnd;
+        if (broken){
+            break;
+        }
+    }
+
+    while (pos < size && data[pos] != '\n'){
+        ++pos;
+    }
+
+    reader->pos = pos;
+    *len = count;
+    return broken ? -1 : 1;
+}
+
+/* library objects, see cnchess.h. */
+struct CnchessPosition{
+    struct Game* game;
+};
+
+struct CnchessEngine{
+    struct TransTable* tt;
+    struct EvalCache* evalCache;
+    struct SearchContext* ctx;    /* of every search, too big for the caller's stack. */
+    size_t ttSizeInMB;
+    struct SearchParams params;
+    struct SearchStats stats;
+    long long timeMs;
+    struct MoveNode pv[MAX_SEARCH_PLY];    /* of the last search. */
+    int pvLen;
+};
+
+static pthread_once_t cnchess_tables_once = PTHREAD_ONCE_INIT;
+
+static void move_from_api(const struct CnchessMove* move, struct MoveNode* node){
+    node->beginRow = BOARD_ACTUAL_ROW_BEGIN + (BOARD_ACTUAL_ROW_LEN - 1 - move->fromRank);
+    node->beginCol = BOARD_ACTUAL_COL_BEGIN + move->fromFile;
+    node->endRow = BOARD_ACTUAL_ROW_BEGIN + (BOARD_ACTUAL_ROW_LEN - 1 - move->toRank);
+    node->endCol = BOARD_ACTUAL_COL_BEGIN + move->toFile;
+}
+
+static void move_to_api(const struct MoveNode* node, struct CnchessMove* move){
+    move->fromRank = BOARD_ACTUAL_ROW_LEN - 1 - (node->beginRow - BOARD_ACTUAL_ROW_BEGIN);
+    move->fromFile = node->beginCol - BOARD_ACTUAL_COL_BEGIN;
+    move->toRank = BOARD_ACTUAL_ROW_LEN - 1 - (node->endRow - BOARD_ACTUAL_ROW_BEGIN);
+    move->toFile = node->endCol - BOARD_ACTUAL_COL_BEGIN;
+}
+
+void cnchess_init(void){
+    pthread_once(&cnchess_tables_once, tables_init);
+}
+
+struct CnchessPosition* cnchess_position_new(void){
+    cnchess_init();
+
+    struct CnchessPosition* pos = (struct CnchessPosition*)malloc(sizeof(struct CnchessPosition));
+    if (pos == NULL){
+        return NULL;
+    }
+
+    pos->game = game_make_new();
+    if (pos->game == NULL){
+        free(pos);
+        return NULL;
+    }
+
+    return pos;
+}
+
+void cnchess_position_free(struct CnchessPosition* pos){
+    if (pos != NULL){
+        game_free(pos->game);
+        free(pos);
+    }
+}
+
+int cnchess_position_set_fen(struct CnchessPosition* pos, const char* fen){
+    assert(pos != NULL && fen != NULL);
+
+    if (!board_set_fen(&(pos->game->board), fen)){
+        return 0;
+    }
+
+    pos->game->record.length = 0;
+    return 1;
+}
+
+int cnchess_position_get_fen(const struct CnchessPosition* pos, char* buf, size_t len){
+    assert(pos != NULL && buf != NULL);
+
+    const struct ChessBoard* cb = &(pos->game->board);
+    char fen[CNCHESS_FEN_BUFFER_LEN];
+    size_t n = 0;
+    int r, c, empty;
+
+    for (r = BOARD_ACTUAL_ROW_BEGIN; r < BOARD_ACTUAL_ROW_BEGIN + BOARD_ACTUAL_ROW_LEN; ++r){
+        empty = 0;
+
+        for (c = BOARD_ACTUAL_COL_BEGIN; c < BOARD_ACTUAL_COL_BEGIN + BOARD_ACTUAL_COL_LEN; ++c){
+            if (cb->data[r][c] == P_EE){
+                ++empty;
+                continue;
+            }
+
+            if (empty > 0){
+                fen[n++] = (char)('0' + empty);
+                empty = 0;
+            }
+
+            fen[n++] = piece_get_fen_char[cb->data[r][c]];
+        }
+
+        if (empty > 0){
+            fen[n++] = (char)('0' + empty);
+        }
+
+        if (r < BOARD_ACTUAL_ROW_BEGIN + BOARD_ACTUAL_ROW_LEN - 1){
+            fen[n++] = '/';
+        }
+    }
+
+    snprintf(fen + n, sizeof(fen) - n, " %c - - 0 %lu", (cb->side == PS_DOWN) ? 'w' : 'b', (unsigned long)(pos->game->record.length / 2 + 1));
+    if (strlen(fen) + 1 > len){
+        return 0;
+    }
+
+    strcpy(buf, fen);
+    return 1;
+}
+
+enum CnchessSide cnchess_position_side(const struct CnchessPosition* pos){
+    assert(pos != NULL);
+    return (pos->game->board.side == PS_DOWN) ? CNCHESS_SIDE_DOWN : CNCHESS_SIDE_UP;
+}
+
+void cnchess_position_print(const struct CnchessPosition* pos){
+    assert(pos != NULL);
+    board_print_to_console(&(pos->game->board));
+}
+
+size_t cnchess_position_legal_moves(struct CnchessPosition* pos, struct CnchessMove* moves, size_t capacity){
+    assert(pos != NULL && (moves != NULL || capacity == 0));
+
+    struct PossibleMoves pm;
+    size_t i;
+
+    pm.len = 0;
+    board_gen_legal_moves(&(pos->game->board), &pm);
+
+    for (i = 0; i < pm.len && i < capacity; ++i){
+        move_to_api(&(pm.data[i]), &(moves[i]));
+    }
+
+    return pm.len;
+}
+
+int cnchess_position_make_move(struct CnchessPosition* pos, const struct CnchessMove* move){
+    assert(pos != NULL && move != NULL);
+
+    struct PossibleMoves pm;
+    struct MoveNode node;
+    size_t i;
+
+    if (move->fromFile < 0 || move->fromFile >= BOARD_ACTUAL_COL_LEN || move->toFile < 0 || move->toFile >= BOARD_ACTUAL_COL_LEN ||
+        move->fromRank < 0 || move->fromRank >= BOARD_ACTUAL_ROW_LEN || move->toRank < 0 || move->toRank >= BOARD_ACTUAL_ROW_LEN){
+        return 0;
+    }
+
+    move_from_api(move, &node);
+    pm.len = 0;
+    board_gen_legal_moves(&(pos->game->board), &pm);
+
+    for (i = 0; i < pm.len; ++i){
+        if (move_is_same(&(pm.data[i]), &node)){
+            return game_move(pos->game, &node) == GS_ONGOING;
+        }
+    }
+
+    return 0;
+}
+
+int cnchess_position_unmake_move(struct CnchessPosition* pos){
+    assert(pos != NULL);
+
+    if (pos->game->record.length == 0){
+        return 0;
+    }
+
+    game_undo(pos->game);
+    return 1;
+}
+
+int cnchess_position_book_move(struct CnchessPosition* pos, struct CnchessMove* move){
+    assert(pos != NULL && move != NULL);
+
+    struct MoveNode node;
+    if (!opening_book_probe(&(pos->game->board), &node)){
+        return 0;
+    }
+
+    move_to_api(&node, move);
+    return 1;
+}
+
+/* the search plays by the game rules, where a general may be left attacked, it only happens when every move loses. */
+static int cnchess_move_is_legal(const struct PossibleMoves* pm, const struct MoveNode* move){
+    size_t i;
+    for (i = 0; i < pm->len; ++i){
+        if (move_is_same(&(pm->data[i]), move)){
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+/* record files keep games played from the default board, a position set by FEN may not be one. */
+static int cnchess_record_is_from_default(const struct GameRecord* rec, const struct ChessBoard* cb){
+    struct ChessBoard start, initial;
+    size_t i = rec->length;
+
+    memcpy(&start, cb, sizeof(struct ChessBoard));
+    while (i-- > 0){
+        board_undo(&start, &(rec->history[i]));
+    }
+
+    board_init(&initial);
+    return start.side == initial.side && memcmp(start.data, initial.data, sizeof(initial.data)) == 0;
+}
+
+int cnchess_position_save(const struct CnchessPosition* pos, const char* path, enum CnchessResult result){
+    assert(pos != NULL && path != NULL);
+
+    struct RecordWriter writer;
+    int ok;
+
+    if (!cnchess_record_is_from_default(&(pos->game->record), &(pos->game->board))){
+        errno = EINVAL;
+        return 0;
+    }
+
+    if (!record_writer_open(&writer, path)){
+        return 0;
+    }
+
+    /* enum CnchessResult is in the order of enum RecordResult. */
+    record_writer_write_game(&writer, &(pos->game->record), (result <= CNCHESS_RESULT_DRAW) ? (enum RecordResult)result : RR_UNKNOWN);
+    ok = !ferror(writer.fp);
+    record_writer_close(&writer);
+    return ok;
+}
+
+int cnchess_position_load(struct CnchessPosition* pos, const char* path, size_t index, enum CnchessResult* result){
+    assert(pos != NULL && path != NULL);
+
+    struct RecordReader reader;
+    struct MoveNode* moves = (struct MoveNode*)malloc(MAX_HISOTRY_BUF_LEN * sizeof(struct MoveNode));
+    struct Game* game = NULL;
+    struct PossibleMoves pm;
+    enum RecordResult gameResult;
+    size_t len = 0, i;
+    int ret;
+
+    if (moves == NULL || !record_reader_open(&reader, path)){
+        free(moves);
+        return 0;
+    }
+
+    /* broken games are counted too, game index of a text record is its line. */
+    do {
+        ret = record_reader_next_game(&reader, moves, MAX_HISOTRY_BUF_LEN, &len, &gameResult);
+    } while (ret != 0 && index-- > 0);
+
+    record_reader_close(&reader);
+    if (ret > 0){
+        game = game_make_new();
+    }
+
+    for (i = 0; game != NULL && i < len; ++i){
+        pm.len = 0;
+        board_gen_legal_moves(&(game->board), &pm);
+        if (!cnchess_move_is_legal(&pm, &(moves[i])) || game_move(game, &(moves[i])) != GS_ONGOING){
+            game_free(game);
+            game = NULL;
+        }
+    }
+
+    free(moves);
+    if (game == NULL){
+        return 0;
+    }
+
+    game_free(pos->game);
+    pos->game = game;
+    if (result != NULL){
+        *result = (enum CnchessResult)gameResult;
+    }
+
+    return 1;
+}
+
+int cnchess_move_from_str(const char* str, struct CnchessMove* move){
+    assert(str != NULL && move != NULL);
+
+    char buf[4];
+    int i;
+
+    for (i = 0; i < 4; ++i){
+        if (i == 2 && *str == '-'){
+            ++str;
+        }
+
+        buf[i] = *str;
+        if (*str == '\0'){
+            return 0;
+        }
+
+        ++str;
+    }
+
+    for (i = 0; i < 4; i += 2){
+        if (buf[i] >= 'A' && buf[i] <= 'I'){
+            buf[i] = buf[i] - 'A' + 'a';
+        }
+
+        if (!(buf[i] >= 'a' && buf[i] <= 'i') || !(buf[i + 1] >= '0' && buf[i + 1] <= '9')){
+            return 0;
+        }
+    }
+
+    move->fromFile = buf[0] - 'a';
+    move->fromRank = buf[1] - '0';
+    move->toFile = buf[2] - 'a';
+    move->toRank = buf[3] - '0';
+    return 1;
+}
+
+int cnchess_move_to_str(const struct CnchessMove* move, char* buf, size_t len){
+    assert(move != NULL && buf != NULL);
+
+    if (len < CNCHESS_MOVE_STR_LEN){
+        return 0;
+    }
+
+    buf[0] = (char)('a' + move->fromFile);
+    buf[1] = (char)('0' + move->fromRank);
+    buf[2] = (char)('a' + move->toFile);
+    buf[3] = (char)('0' + move->toRank);
+    buf[4] = '\0';
+    return 1;
+}
+
+/* the engine takes tt, it is freed if the engine can't be made. return NULL if tt is NULL or out of memory. */
+static struct CnchessEngine* cnchess_engine_make(struct TransTable* tt, size_t ttSizeInMB){
+    if (tt == NULL){
+        return NULL;
+    }
+
+    struct CnchessEngine* engine = (struct CnchessEngine*)malloc(sizeof(struct CnchessEngine));
+    struct SearchContext* ctx = (struct SearchContext*)malloc(sizeof(struct SearchContext));
+    struct EvalCache* evalCache = eval_cache_make_new();
+    if (engine == NULL || ctx == NULL || evalCache == NULL){
+        free(engine);
+        free(ctx);
+        free(evalCache);
+        trans_table_free(tt);
+        return NULL;
+    }
+
+    engine->tt = tt;
+    engine->evalCache = evalCache;
+    engine->ctx = ctx;
+    engine->ttSizeInMB = ttSizeInMB;
+    engine->pvLen = 0;
+    search_params_init(&(engine->params));
+    memset(&(engine->stats), 0, sizeof(struct SearchStats));
+    engine->timeMs = 0;
+    return engine;
+}
+
+struct CnchessEngine* cnchess_engine_new(size_t ttSizeInMB){
+    cnchess_init();
+    return cnchess_engine_make(trans_table_make_new(ttSizeInMB, 0), ttSizeInMB);
+}
+
+struct CnchessEngine* cnchess_engine_new_shared(const char* shmName, size_t ttSizeInMB, int hugePages){
+    assert(shmName != NULL);
+    cnchess_init();
+
+    return cnchess_engine_make(trans_table_make_shared(shmName, ttSizeInMB, hugePages), ttSizeInMB);
+}
+
+int cnchess_shared_table_remove(const char* shmName){
+    assert(shmName != NULL);
+    return shm_unlink(shmName) == 0;
+}
+
+void cnchess_engine_free(struct CnchessEngine* engine){
+    if (engine != NULL){
+        trans_table_free(engine->tt);
+        free(engine->evalCache);
+        free(engine->ctx);
+        free(engine);
+    }
+}
+
+void cnchess_engine_clear(struct CnchessEngine* engine){
+    assert(engine != NULL);
+    trans_table_clear(engine->tt);
+    eval_cache_clear(engine->evalCache);
+}
+
+int cnchess_engine_set_option(struct CnchessEngine* engine, const char* name, int value){
+    assert(engine != NULL && name != NULL);
+    return search_params_set(&(engine->params), name, value);
+}
+
+/* set up a library search, return the depth to search in plies, or 0 if the side to move has no legal move. */
+static unsigned int cnchess_engine_prepare(struct CnchessEngine* engine, const struct CnchessPosition* pos, const struct CnchessLimits* limits,
+                                           struct SearchContext* ctx, struct PossibleMoves* pm){
+    unsigned int depth = (limits != NULL && limits->depth > 0) ? limits->depth : CNCHESS_AI_SEARCH_DEPTH + 1;
+    struct TimeControl tc;
+
+    search_context_init(ctx, &(pos->game->board), &(pos->game->record), engine->tt);
+    ctx->evalCache = engine->evalCache;
+    ctx->params = &(engine->params);
+    pm->len = 0;
+    board_gen_legal_moves(&(ctx->board), pm);
+    if (pm->len == 0){
+        memset(&(engine->stats), 0, sizeof(struct SearchStats));
+        engine->timeMs = 0;
+        engine->pvLen = 0;
+        return 0;
+    }
+
+    if (limits != NULL){
+        search_context_set_limits(ctx, limits->nodes, limits->timeMs, limits->stop);
+
+        if (limits->clock != NULL){
+            tc.remainingMs = limits->clock->remainingMs;
+            tc.incrementMs = limits->clock->incrementMs;
+            tc.movesToGo = limits->clock->movesToGo;
+            tc.byoyomiMs = limits->clock->byoyomiMs;
+            tc.overheadMs = limits->clock->overheadMs;
+            search_context_set_clock(ctx, &tc);
+
+            if (limits->depth == 0){
+                depth = MAX_SEARCH_PLY - 1;
+            }
+        }
+    }
+
+    return depth;
+}
+
+/* keep the principal variation and the statistics of a finished library search. */
+static void cnchess_engine_finish(struct CnchessEngine* engine, const struct SearchContext* ctx, long long begin){
+    memcpy(engine->pv, ctx->bestLine, ctx->bestLineLen * sizeof(struct MoveNode));
+    engine->pvLen = ctx->bestLineLen;
+    memcpy(&(engine->stats), &(ctx->stats), sizeof(struct SearchStats));
+    engine->timeMs = time_now_ms() - begin;
+}
+
+int cnchess_engine_search(struct CnchessEngine* engine, const struct CnchessPosition* pos, const struct CnchessLimits* limits, struct CnchessMove* best, int* score){
+    assert(engine != NULL && pos != NULL && best != NULL);
+
+    struct SearchContext* ctx = engine->ctx;
+    struct PossibleMoves pm;
+    struct MoveNode node;
+    long long begin = time_now_ms();
+    unsigned int depth = cnchess_engine_prepare(engine, pos, limits, ctx, &pm);
+
+    if (depth == 0){
+        return 0;
+    }
+
+    /* board_gen_best_move() searches depth + 1 plies, the library counts plies. */
+    int value;
+    if (limits != NULL && limits->threads > 1){
+        value = board_gen_best_move_split(ctx, depth - 1, limits->threads, engine->ttSizeInMB, &node);
+    }
+    else {
+        value = board_gen_best_move(ctx, depth - 1, &node);
+    }
+
+    if (!cnchess_move_is_legal(&pm, &node)){
+        memcpy(&node, &(pm.data[0]), sizeof(struct MoveNode));
+        memcpy(&(ctx->bestLine[0]), &node, sizeof(struct MoveNode));
+        ctx->bestLineLen = 1;
+    }
+
+    cnchess_engine_finish(engine, ctx, begin);
+
+    move_to_api(&node, best);
+    if (score != NULL){
+        *score = (pos->game->board.side == PS_DOWN) ? value : -value;
+    }
+
+    return 1;
+}
+
+size_t cnchess_engine_search_lines(struct CnchessEngine* engine, const struct CnchessPosition* pos, const struct CnchessLimits* limits,
+                                   struct CnchessLine* lines, size_t lineCount){
+    assert(engine != NULL && pos != NULL && (lines != NULL || lineCount == 0));
+
+    struct SearchContext* ctx = engine->ctx;
+    struct PossibleMoves pm;
+    long long begin = time_now_ms();
+    unsigned int depth = cnchess_engine_prepare(engine, pos, limits, ctx, &pm);
+    size_t found, count = 0, i, j;
+
+    if (depth == 0 || lineCount == 0){
+        return 0;
+    }
+
+    struct SearchLine* searchLines = (struct SearchLine*)malloc(lineCount * sizeof(struct SearchLine));
+    found = (searchLines != NULL) ? board_gen_best_lines(ctx, depth - 1, searchLines, lineCount) : 0;
+    if (found == 0){    /* out of memory. */
+        free(searchLines);
+        return 0;
+    }
+
+    for (i = 0; i < found; ++i){
+        if (!cnchess_move_is_legal(&pm, &(searchLines[i].moves[0]))){
+            continue;
+        }
+
+        for (j = 0; j < (size_t)searchLines[i].len && j < CNCHESS_MAX_PV; ++j){
+            move_to_api(&(searchLines[i].moves[j]), &(lines[count].moves[j]));
+        }
+
+        lines[count].len = j;
+        lines[count].score = (pos->game->board.side == PS_DOWN) ? searchLines[i].value : -searchLines[i].value;
+        ++count;
+    }
+
+    if (count == 0){    /* every move loses the general. */
+        move_to_api(&(pm.data[0]), &(lines[0].moves[0]));
+        lines[0].len = 1;
+        lines[0].score = (pos->game->board.side == PS_DOWN) ? searchLines[0].value : -searchLines[0].value;
+        memcpy(&(ctx->bestLine[0]), &(pm.data[0]), sizeof(struct MoveNode));
+        ctx->bestLineLen = 1;
+        count = 1;
+    }
+    else if (!cnchess_move_is_legal(&pm, &(ctx->bestLine[0]))){
+        for (j = 0; j < lines[0].len; ++j){
+            move_from_api(&(lines[0].moves[j]), &(ctx->bestLine[j]));
+        }
+
+        ctx->bestLineLen = (int)lines[0].len;
+    }
+
+    cnchess_engine_finish(engine, ctx, begin);
+    free(searchLines);
+    return count;
+}
+
+void cnchess_engine_stats(const struct CnchessEngine* engine, struct CnchessStats* stats){
+    assert(engine != NULL && stats != NULL);
+
+    stats->nodes = engine->stats.nodes;
+    stats->generatedMoves = engine->stats.generatedMoves;
+    stats->depth = engine->stats.depth;
+    stats->ttProbes = engine->stats.ttProbes;
+    stats->ttHits = engine->stats.ttHits;
+    stats->evals = engine->stats.evals;
+    stats->evalLazy = engine->stats.evalLazy;
+    stats->evalCacheProbes = engine->stats.evalCacheProbes;
+    stats->evalCacheHits = engine->stats.evalCacheHits;
+    stats->evalTimeMs = engine->stats.evalTimeNs / 1000000;
+    stats->timeMs = engine->timeMs;
+}
+
+size_t cnchess_engine_pv(const struct CnchessEngine* engine, struct CnchessMove* moves, size_t capacity){
+    assert(engine != NULL && (moves != NULL || capacity == 0));
+
+    size_t i;
+    for (i = 0; i < (size_t)engine->pvLen && i < capacity; ++i){
+        move_to_api(&(engine->pv[i]), &(moves[i]));
+    }
+
+    return engine->pvLen;
+}
+
+#ifndef CNCHESS_NO_MAIN
+
+/* 
+    wrapper on malloc().
+    if out of memory, then log the error and exit the program. 
+    you should call free() on the returned value later.
+*/
+static void* safe_malloc(size_t size){
+    void* buffer = malloc(size);
+    if (buffer == NULL){
+        fprintf(stderr, "%s: %s(%d) error: malloc() out of memory\n", __FILE__, __FUNCTION__, __LINE__);
+        exit(EXIT_FAILURE);
+    }
+
+    return buffer;
+}
+
+/* 
+    wrapper on game_make_new().
+    if out of memory, then log the error and exit the program. 
+*/
+static struct Game* safe_game_make_new(void){
+    struct Game* game = game_make_new();
+    if (game == NULL){
+        fprintf(stderr, "%s: %s(%d) error: game_make_new() out of memory\n", __FILE__, __FUNCTION__, __LINE__);
+        exit(EXIT_FAILURE);
+    }
+
+    return game;
+}
+
+/* 
+    wrapper on game_move().
+    if out of memory, then log the error and exit the program. 
+*/
+static enum GameStatus safe_game_move(struct Game* game, const struct MoveNode* moveNode){
+    enum GameStatus status = game_move(game, moveNode);
+    if (status == GS_OUT_OF_MEMORY){
+        fprintf(stderr, "%s: %s(%d) error: game_move() out of memory\n", __FILE__, __FUNCTION__, __LINE__);
+        exit(EXIT_FAILURE);
+    }
+
+    return status;
+}
+
+/* 
+    wrapper on trans_table_make_new().
+    if out of memory, then log the error and exit the program. 
+*/
+static struct TransTable* safe_trans_table_make_new(size_t sizeInMB, int hugePages){
+    struct TransTable* tt = trans_table_make_new(sizeInMB, hugePages);
+    if (tt == NULL){
+        fprintf(stderr, "%s: %s(%d) error: trans_table_make_new() out of memory\n", __FILE__, __FUNCTION__, __LINE__);
+        exit(EXIT_FAILURE);
+    }
+
+    return tt;
+}
+
+/*
+    get a user input line.
+    if the length of the user input exceed the given param len,
+    then the exceed parts will be ignored, like this:
+
+    limits: 5
+
+    abcdefg
+    abcd
+*/
+static int get_line(char* buf, size_t len){
+	assert(buf != NULL && len != 0);
+	
+    int count = 0;
+    char c;
+
+    while(1) {
+        c = getchar();
+        if(c == '\n' || c == EOF){
+            break;
+        }
+
+        if ((size_t)count < len - 1){
+            buf[count] = c;
+            ++count;
+        }
+    }
+
+    buf[count] = '\0';
+    return count;
+}
+
+/* given move is fit for rule ? return 0 if not. */
+static int check_rule(struct ChessBoard* cb, const struct MoveNode* moveNode){
+    assert(cb != NULL && moveNode != NULL);
+
+    int valid = 0;
+    enum Piece p = cb->data[moveNode->beginRow][moveNode->beginCol];
+    struct PossibleMoves pm;
+    pm.len = 0;
+    board_gen_possible_moves(cb, piece_get_side[p], GEN_ALL, &pm);
+
+    size_t i;
+    struct MoveNode* cursor;
+    for (i = 0;i < pm.len;++i){
+        cursor = &(pm.data[i]);
+
+        if (memcmp(cursor, moveNode, sizeof(struct MoveNode)) == 0){
+            valid = 1;
+            break;
+        }
+    }
+
+    return valid;
+}
+
+/* 
+    a cheap safety check of a move: can the enemy win material by taking the moved piece ?
+    return the material lost by static exchange evaluation, 0 if the move is safe.
+*/
+static int check_move_loses_material(struct ChessBoard* cb, const struct MoveNode* move){
+    assert(cb != NULL && move != NULL);
+
+    return COMPARE_MAX(-board_see(cb, move), 0);
+}
+
+/* every one can only move his pieces, not the enemy's. */
+static int check_is_this_your_piece(const struct ChessBoard* cb, const struct MoveNode* move, enum PieceSide side){
+    enum Piece p = cb->data[move->beginRow][move->beginCol];
+    return piece_get_side[p] == side;
+}
+
+/* if no one wins, return PS_EXTRA. */
+static enum PieceSide check_winner(const struct ChessBoard* cb){
+    assert(cb != NULL);
+
+    int upAlive = 0;
+    int downAlive = 0;
+
+    int r, c;
+    for (r = BOARD_9_PALACE_UP_TOP; r <= BOARD_9_PALACE_UP_BOTTOM; ++r) {
+        for (c = BOARD_9_PALACE_UP_LEFT; c <= BOARD_9_PALACE_UP_RIGHT; ++c) {
+            if (cb->data[r][c] == P_UG) {
+                upAlive = 1;
+                break;
+            }
+        }
+    }
+
+    for (r = BOARD_9_PALACE_DOWN_TOP; r <= BOARD_9_PALACE_DOWN_BOTTOM; ++r) {
+        for (c = BOARD_9_PALACE_DOWN_LEFT; c <= BOARD_9_PALACE_DOWN_RIGHT; ++c) {
+            if (cb->data[r][c] == P_DG) {
+                downAlive = 1;
+                break;
+            }
+        }
+    }
+
+    if (upAlive && downAlive) {
+        return PS_EXTRA;
+    }
+    else if (upAlive) {
+        return PS_UP;
+    }
+    else {
+        return PS_DOWN;
+    }
+}
+
+/* the result of a game which the given side has won, PS_EXTRA means a draw. */
+static enum RecordResult record_result_of_winner(enum PieceSide winner){
+    return (winner == PS_DOWN) ? RR_DOWN_WIN : ((winner == PS_UP) ? RR_UP_WIN : RR_DRAW);
+}
+
+static void print_help_page(void){
+    printf("\n=======================================\n");
+    printf("Help Page\n\n");
+    printf("    1. help         - this page.\n");
+    printf("    2. b2e2         - input like this will be parsed as a move.\n");
+    printf("    3. undo         - undo the previous move.\n");
+    printf("    4. exit or quit - exit the game.\n");
+    printf("    5. remake       - remake the game.\n");
+    printf("    6. advice       - give me the best moves, with their scores and lines.\n");
+    printf("    7. analyse      - score every move played so far, and show the better ones.\n\n");
+    printf("  The characters on the board have the following relationships: \n\n");
+    printf("    P -> AI side pawn.\n");
+    printf("    C -> AI side cannon.\n");
+    printf("    R -> AI side rook.\n");
+    printf("    N -> AI side knight.\n");
+    printf("    B -> AI side bishop.\n");
+    printf("    A -> AI side advisor.\n");
+    printf("    G -> AI side general.\n");
+    printf("    p -> our pawn.\n");
+    printf("    c -> our cannon.\n");
+    printf("    r -> our rook.\n");
+    printf("    n -> our knight.\n");
+    printf("    b -> our bishop.\n");
+    printf("    a -> our advisor.\n");
+    printf("    g -> our general.\n");
+    printf("    . -> no piece here.\n");
+    printf("=======================================\n");
+    printf("Press any key to continue.\n");
+
+    (void)getchar();
+}
+
+#define USER_SIDE  PS_DOWN
+#define AI_SIDE    PS_UP
+
+/* transposition table size of the game. */
+#define CNCHESS_TRANS_TABLE_SIZE_MB 16
+
+/* how many moves advice suggests. */
+#define ADVICE_LINES 3
+
+/* print moves in a line like " h2e2 h9g7". */
+static void print_line(const struct MoveNode* moves, int len){
+    char moveStr[MOVE_TO_STR_BUFFER_LEN];
+    int i;
+
+    for (i = 0; i < len; ++i){
+        convert_move_to_str(&(moves[i]), moveStr, MOVE_TO_STR_BUFFER_LEN);
+        printf(" %s", moveStr);
+    }
+
+    printf("\n");
+}
+
+/* 
+    charge a move that took elapsedMs to a clock, return 0 if its time ran out.
+    once the main time is used up, a move may take up to the byoyomi. with moves to go, controlMs is added every controlMoves moves.
+*/
+static int time_control_spend(struct TimeControl* tc, long long elapsedMs, long long controlMs, unsigned int controlMoves){
+    if (elapsedMs > tc->remainingMs){
+        if (elapsedMs - tc->remainingMs > tc->byoyomiMs){
+            tc->remainingMs = 0;
+            return 0;
+        }
+
+        tc->remainingMs = 0;
+    }
+    else {
+        tc->remainingMs -= elapsedMs;
+    }
+
+    tc->remainingMs += tc->incrementMs;
+    if (controlMoves > 0 && --(tc->movesToGo) == 0){
+        tc->remainingMs += controlMs;
+        tc->movesToGo = controlMoves;
+    }
+
+    return 1;
+}
+
+/* 
+    bench positions, every one is the moves played from the default board.
+    keep them fixed, the numbers of different builds are only comparable on the same positions.
+*/
+static const char* BENCH_POSITIONS[] = {
+    "",
+    "h2e2 b9c7 b2c2 h7e7 h0g2 a9b9 i0h0 h9g7 a0a1 b7a7 b0a2 a7a3",
+    "c3c4 b9c7 b0c2 a9a8 a0a1 h9g7 h2h6 i9i8 h0g2 a8d8 e3e4 d8d3 h6e6 c7e6 e4e5 b7e7",
+    "b0c2 b9c7 a0a1 a9a8 h0g2 h7g7 h2h7 c9e7 a1d1 i9i7 h7h6 g7g3 i0i1 g3c3 g2f4 c3c0 d0e1 i7h7 h6e6 c7e6",
+    "h2e2 h7e7 e2e6 d9e8 b0c2 b9c7 e6e5 a9a8 a0a1 h9g7 h0g2 i9h9 i0h0 h9h0 g2h0 c7e6 e5e7 c9e7 e3e4 e6d4 e4e5 d4c2 a1c1 b7b3",
+    "g3g4 c6c5 b0c2 b9c7 a0a1 h9g7 h2g2 h7h2 c0e2 a9a8 h0i2 h2h3 i0h0 h3c3 g2g6 i9h9 h0h9 g7h9 g6h6 c3i3 g4g5 h9i7 c2d4 a8d8 d4c6 b7b5 a1c1 b5g5 c1c5 d8h8"
+};
+
+/* play the moves of a bench position on a new game, return NULL if a move breaks the rules. */
+static struct Game* bench_make_position(size_t index){
+    struct Game* game = safe_game_make_new();
+    const char* cursor = BENCH_POSITIONS[index];
+    struct MoveNode move;
+
+    while (*cursor != '\0'){
+        convert_input_to_move((char*)cursor, &move);
+
+        if (!check_rule(&(game->board), &move)){
+            fprintf(stderr, "bench position %lu has an illegal move: %.4s\n", (unsigned long)index, cursor);
+            game_free(game);
+            return NULL;
+        }
+
+        safe_game_move(game, &move);
+        cursor += (cursor[4] == ' ') ? 5 : 4;
+    }
+
+    return game;
+}
+
+/* how many times every piece is generated in the move generator micro-benchmark. */
+#define BENCH_MOVEGEN_ROUNDS 1000000
+
+/*
+    move generator throughput for every piece type, over all pieces of that type in the bench positions.
+    usage: cnchess bench movegen
+*/
+static int run_bench_movegen(void){
+    static const char* typeNames[] = { "pawn", "cannon", "rook", "knight", "bishop", "advisor", "general" };
+    struct Game* games[sizeof(BENCH_POSITIONS) / sizeof(BENCH_POSITIONS[0])];
+    size_t gameCount = sizeof(BENCH_POSITIONS) / sizeof(BENCH_POSITIONS[0]);
+    struct PossibleMoves pm;
+    size_t i;
+    enum PieceType type;
+    int r, c, round;
+
+    for (i = 0; i < gameCount; ++i){
+        if ((games[i] = bench_make_position(i)) == NULL){
+            while (i > 0){
+                game_free(games[--i]);
+            }
+
+            return EXIT_FAILURE;
+        }
+    }
+
+    for (type = PT_PAWN; type <= PT_GENERAL; ++type){
+        /* find the pieces first, so only the generators are timed. */
+        struct { struct ChessBoard* cb; int r, c; } squares[MAX_ONE_SIDE_POSSIBLE_MOVES_LEN];
+        size_t squareCount = 0, k;
+
+        for (i = 0; i < gameCount; ++i){
+            for (r = BOARD_ACTUAL_ROW_BEGIN; r < BOARD_ACTUAL_ROW_BEGIN + BOARD_ACTUAL_ROW_LEN; ++r){
+                for (c = BOARD_ACTUAL_COL_BEGIN; c < BOARD_ACTUAL_COL_BEGIN + BOARD_ACTUAL_COL_LEN; ++c){
+                    if (piece_get_type[games[i]->board.data[r][c]] == type){
+                        squares[squareCount].cb = &(games[i]->board);
+                        squares[squareCount].r = r;
+                        squares[squareCount].c = c;
+                        ++squareCount;
+                    }
+                }
+            }
+        }
+
+        unsigned long long calls = 0, moves = 0;
+        long long begin = time_now_ms();
+
+        for (round = 0; round < BENCH_MOVEGEN_ROUNDS; ++round){
+            for (k = 0; k < squareCount; ++k){
+                pm.len = 0;
+                board_gen_possible_moves_for_piece(squares[k].cb, &pm, squares[k].r, squares[k].c, GEN_ALL);
+                moves += pm.len;
+            }
+
+            calls += squareCount;
+        }
+
+        long long elapsed = time_now_ms() - begin;
+        printf("%-8s calls %llu moves %llu time %lld ms, %.1f ns per call, %.1f M moves/s\n", typeNames[type], calls, moves, elapsed, 
+            calls ? elapsed * 1e6 / calls : 0.0, elapsed ? moves / (elapsed * 1000.0) : 0.0);
+    }
+
+    for (i = 0; i < gameCount; ++i){
+        game_free(games[i]);
+    }
+
+    return EXIT_SUCCESS;
+}
+
+/*
+    run the search on the bench positions and print the statistics, used for comparing builds.
+    search parameters can be set for tuning, like futility_margin_1=50.
+    usage: cnchess bench [depth | movegen] [name=value ...]
+*/
+static int run_bench(int argc, char* argv[]){
+    if (argc > 2 && strcmp(argv[2], "movegen") == 0){
+        return run_bench_movegen();
+    }
+
+    unsigned int depth = CNCHESS_AI_SEARCH_DEPTH;
+    struct SearchParams params;
+    int arg;
+
+    search_params_init(&params);
+    for (arg = 2; arg < argc; ++arg){
+        char* equal = strchr(argv[arg], '=');
+
+        if (equal == NULL){
+            depth = (unsigned int)atoi(argv[arg]);
+            continue;
+        }
+
+        *equal = '\0';
+        if (!search_params_set(&params, argv[arg], atoi(equal + 1))){
+            fprintf(stderr, "unknown search parameter: %s\n", argv[arg]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    struct TransTable* tt = safe_trans_table_make_new(CNCHESS_TRANS_TABLE_SIZE_MB, 0);
+    struct EvalCache* evalCache = (struct EvalCache*)safe_malloc(sizeof(struct EvalCache));
+    struct SearchContext* ctx = (struct SearchContext*)safe_malloc(sizeof(struct SearchContext));
+    struct MoveNode move;
+    char moveStr[MOVE_TO_STR_BUFFER_LEN];
+    unsigned long long totalNodes = 0, totalGenerated = 0;
+    unsigned long long totalEvals = 0, totalLazy = 0, totalEvalProbes = 0, totalEvalHits = 0;
+    long long totalTime = 0, totalEvalTimeNs = 0;
+    size_t i;
+
+    for (i = 0; i < sizeof(BENCH_POSITIONS) / sizeof(BENCH_POSITIONS[0]); ++i){
+        struct Game* game = bench_make_position(i);
+
+        if (game == NULL){
+            trans_table_free(tt);
+            free(evalCache);
+            free(ctx);
+            return EXIT_FAILURE;
+        }
+
+        trans_table_clear(tt);
+        eval_cache_clear(evalCache);
+        search_context_init(ctx, &(game->board), &(game->record), tt);
+        ctx->evalCache = evalCache;
+        ctx->params = &params;
+
+        long long begin = time_now_ms();
+        int score = board_gen_best_move(ctx, depth, &move);
+        long long elapsed = time_now_ms() - begin;
+
+        convert_move_to_str(&move, moveStr, MOVE_TO_STR_BUFFER_LEN);
+        printf("position %lu: best %s score %d nodes %llu generated %llu time %lld ms\n", 
+            (unsigned long)i, moveStr, score, ctx->stats.nodes, ctx->stats.generatedMoves, elapsed);
+
+        totalNodes += ctx->stats.nodes;
+        totalGenerated += ctx->stats.generatedMoves;
+        totalEvals += ctx->stats.evals;
+        totalLazy += ctx->stats.evalLazy;
+        totalEvalProbes += ctx->stats.evalCacheProbes;
+        totalEvalHits += ctx->stats.evalCacheHits;
+        totalEvalTimeNs += ctx->stats.evalTimeNs;
+        totalTime += elapsed;
+        game_free(game);
+    }
+
+    printf("total: nodes %llu generated %llu (%.2f per node) time %lld ms nps %.0f\n",
+        totalNodes, totalGenerated, totalNodes ? (double)totalGenerated / totalNodes : 0.0,
+        totalTime, totalTime ? totalNodes * 1000.0 / totalTime : 0.0);
+    printf("eval: evals %llu lazy %.1f%% cache hits %.1f%% time %lld ms\n", totalEvals, totalEvals ? totalLazy * 100.0 / totalEvals : 0.0,
+        totalEvalProbes ? totalEvalHits * 100.0 / totalEvalProbes : 0.0, totalEvalTimeNs / 1000000);
+
+    trans_table_free(tt);
+    free(evalCache);
+    free(ctx);
+    return EXIT_SUCCESS;
+}
+
+/*
+    replay every game of a record file from the start position, as fast as possible.
+    with --check every move is checked against the move generator, and the rest of a game is skipped at the first illegal move.
+    usage: cnchess replay FILE [--check]
+*/
+static int run_replay(int argc, char* argv[]){
+    if (argc < 3){
+        fprintf(stderr, "usage: cnchess replay FILE [--check]\n");
+        return EXIT_FAILURE;
+    }
+
+    int check = (argc > 3 && strcmp(argv[3], "--check") == 0);
+    struct RecordReader reader;
+    struct MoveNode* moves = (struct MoveNode*)safe_malloc(MAX_HISOTRY_BUF_LEN * sizeof(struct MoveNode));
+    struct ChessBoard cb;
+    struct HistoryNode hist;
+    unsigned long long games = 0, totalMoves = 0, broken = 0, illegal = 0;
+    unsigned long long results[RR_DRAW + 1] = { 0 };
+    enum RecordResult result;
+    size_t len, i;
+    int ret;
+
+    if (!record_reader_open(&reader, argv[2])){
+        fprintf(stderr, "cannot open record file: %s\n", argv[2]);
+        free(moves);
+        return EXIT_FAILURE;
+    }
+
+    long long begin = time_now_ms();
+
+    while ((ret = record_reader_next_game(&reader, moves, MAX_HISOTRY_BUF_LEN, &len, &result)) != 0){
+        if (ret < 0){
+            ++broken;
+            continue;
+        }
+
+        board_init(&cb);
+        for (i = 0; i < len; ++i){
+            if (check && !board_is_pseudo_legal(&cb, &(moves[i]))){
+                ++illegal;
+                break;
+            }
+
+            board_move(&cb, &(moves[i]), &hist);
+        }
+
+        ++games;
+        ++results[result];
+        totalMoves += i;
+    }
+
+    long long elapsed = time_now_ms() - begin;
+
+    printf("%s record, games %llu (1-0 %llu, 0-1 %llu, draw %llu, unfinished %llu) broken %llu\n",
+        reader.binary ? "binary" : "text", games, results[RR_DOWN_WIN], results[RR_UP_WIN], results[RR_DRAW], results[RR_UNKNOWN], broken);
+    printf("moves %llu%s time %lld ms, %.1f M moves/s\n", totalMoves, check ? " checked" : "", elapsed, 
+        elapsed ? totalMoves / (elapsed * 1000.0) : 0.0);
+    if (check){
+        printf("illegal games %llu\n", illegal);
+    }
+
+    record_reader_close(&reader);
+    free(moves);
+    return EXIT_SUCCESS;
+}
+
+/*
+    convert a record file between the formats, the output is appended and its format chosen by the file name.
+    usage: cnchess convert IN OUT
+*/
+static int run_convert(int argc, char* argv[]){
+    if (argc < 4){
+        fprintf(stderr, "usage: cnchess convert IN OUT\n");
+        return EXIT_FAILURE;
+    }
+
+    struct RecordReader reader;
+    struct RecordWriter writer;
+    struct MoveNode* moves;
+    unsigned long long games = 0, broken = 0;
+    enum RecordResult result;
+    size_t len;
+    int ret;
+
+    if (!record_reader_open(&reader, argv[2])){
+        fprintf(stderr, "cannot open record file: %s\n", argv[2]);
+        return EXIT_FAILURE;
+    }
+
+    if (!record_writer_open(&writer, argv[3])){
+        fprintf(stderr, "cannot open record file: %s\n", argv[3]);
+        record_reader_close(&reader);
+        return EXIT_FAILURE;
+    }
+
+    moves = (struct MoveNode*)safe_malloc(MAX_HISOTRY_BUF_LEN * sizeof(struct MoveNode));
+    while ((ret = record_reader_next_game(&reader, moves, MAX_HISOTRY_BUF_LEN, &len, &result)) != 0){
+        if (ret < 0){
+            ++broken;
+            continue;
+        }
+
+        record_writer_write_moves(&writer, moves, sizeof(struct MoveNode), len, result);
+        ++games;
+    }
+
+    printf("converted %llu games, %llu broken games skipped.\n", games, broken);
+
+    free(moves);
+    record_writer_close(&writer);
+    record_reader_close(&reader);
+    return EXIT_SUCCESS;
+}
+
+/*
+    print the static exchange evaluation of a move on a position, see board_see(), for checking it on hand made boards.
+    usage: cnchess see FEN MOVE
+*/
+static int run_see(int argc, char* argv[]){
+    struct ChessBoard cb;
+    struct CnchessMove move;
+    struct MoveNode node;
+
+    if (argc != 4){
+        fprintf(stderr, "usage: cnchess see FEN MOVE\n");
+        return EXIT_FAILURE;
+    }
+
+    if (!board_set_fen(&cb, argv[2])){
+        fprintf(stderr, "invalid FEN: %s\n", argv[2]);
+        return EXIT_FAILURE;
+    }
+
+    if (!cnchess_move_from_str(argv[3], &move)){
+        fprintf(stderr, "illegal move: %s\n", argv[3]);
+        return EXIT_FAILURE;
+    }
+
+    move_from_api(&move, &node);
+    if (!board_is_pseudo_legal(&cb, &node)){
+        fprintf(stderr, "illegal move: %s\n", argv[3]);
+        return EXIT_FAILURE;
+    }
+
+    printf("see %d\n", board_see(&cb, &node));
+    return EXIT_SUCCESS;
+}
+
+/*
+    search one position and print the best move, its score and principal variation.
+    limited by depth and nodes only, the output is the same every run, so builds can be compared byte for byte.
+    without depth, nodes alone limit the search.
+    shared-tt attaches the transposition table in a POSIX shared memory segment, what other processes searched is used then,
+    so the output depends on them. huge-pages 1 asks for huge pages for the shared table.
+    clock searches by a game clock of MS milliseconds, with the increment, moves to go, byoyomi and overhead given.
+    multipv prints the K best moves, one line for each, after the best move line.
+    usage: cnchess search [depth D] [nodes N] [threads T] [tt-size MB] [shared-tt NAME] [huge-pages 0|1]
+                          [clock MS] [inc MS] [moves-to-go N] [byoyomi MS] [overhead MS] [multipv K] [fen FEN] [moves M1 M2 ...]
+*/
+static int run_search(int argc, char* argv[]){
+    struct CnchessPosition* pos = cnchess_position_new();
+    struct CnchessEngine* engine;
+    struct CnchessLimits limits = { .threads = 1 };
+    struct CnchessClock clock = { 0, 0, 0, 0, 0 };
+    size_t ttSizeInMB = CNCHESS_TRANS_TABLE_SIZE_MB;
+    const char* sharedName = NULL;
+    int hugePages = 0;
+    struct CnchessMove best, pv[MAX_SEARCH_PLY];
+    struct CnchessStats stats;
+    char moveStr[CNCHESS_MOVE_STR_LEN];
+    struct CnchessLine* lines = NULL;
+    int arg, score;
+    size_t i, k, pvLen, lineCount = 0, found;
+
+    if (pos == NULL){
+        perror("cnchess_position_new");
+        return EXIT_FAILURE;
+    }
+
+    for (arg = 2; arg < argc; ++arg){
+        if (strcmp(argv[arg], "moves") == 0){
+            for (++arg; arg < argc; ++arg){
+                if (!cnchess_move_from_str(argv[arg], &best) || !cnchess_position_make_move(pos, &best)){
+                    fprintf(stderr, "illegal move: %s\n", argv[arg]);
+                    cnchess_position_free(pos);
+                    return EXIT_FAILURE;
+                }
+            }
+
+            break;
+        }
+
+        if (arg + 1 >= argc){
+            fprintf(stderr, "usage: cnchess search [depth D] [nodes N] [threads T] [tt-size MB] [shared-tt NAME] [huge-pages 0|1]"
+                            " [clock MS] [inc MS] [moves-to-go N] [byoyomi MS] [overhead MS] [multipv K] [fen FEN] [moves M1 M2 ...]\n");
+            cnchess_position_free(pos);
+            return EXIT_FAILURE;
+        }
+
+        if (strcmp(argv[arg], "depth") == 0){
+            limits.depth = (unsigned int)atoi(argv[++arg]);
+        }
+        else if (strcmp(argv[arg], "nodes") == 0){
+            limits.nodes = strtoull(argv[++arg], NULL, 10);
+        }
+        else if (strcmp(argv[arg], "threads") == 0){
+            limits.threads = (unsigned int)atoi(argv[++arg]);
+        }
+        else if (strcmp(argv[arg], "tt-size") == 0){
+            ttSizeInMB = (size_t)strtoull(argv[++arg], NULL, 10);
+        }
+        else if (strcmp(argv[arg], "shared-tt") == 0){
+            sharedName = argv[++arg];
+        }
+        else if (strcmp(argv[arg], "huge-pages") == 0){
+            hugePages = atoi(argv[++arg]);
+        }
+        else if (strcmp(argv[arg], "clock") == 0){
+            clock.remainingMs = atoll(argv[++arg]);
+            limits.clock = &clock;
+        }
+        else if (strcmp(argv[arg], "inc") == 0){
+            clock.incrementMs = atoll(argv[++arg]);
+        }
+        else if (strcmp(argv[arg], "moves-to-go") == 0){
+            clock.movesToGo = (unsigned int)atoi(argv[++arg]);
+        }
+        else if (strcmp(argv[arg], "byoyomi") == 0){
+            clock.byoyomiMs = atoll(argv[++arg]);
+            limits.clock = &clock;
+        }
+        else if (strcmp(argv[arg], "overhead") == 0){
+            clock.overheadMs = atoll(argv[++arg]);
+        }
+        else if (strcmp(argv[arg], "multipv") == 0){
+            lineCount = (size_t)strtoull(argv[++arg], NULL, 10);
+        }
+        else if (strcmp(argv[arg], "fen") == 0){
+            if (!cnchess_position_set_fen(pos, argv[++arg])){
+                fprintf(stderr, "invalid FEN: %s\n", argv[arg]);
+                cnchess_position_free(pos);
+                return EXIT_FAILURE;
+            }
+        }
+        else {
+            fprintf(stderr, "unknown search option: %s\n", argv[arg]);
+            cnchess_position_free(pos);
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (limits.depth == 0 && limits.nodes != 0){
+        limits.depth = MAX_SEARCH_PLY - 1;
+    }
+
+    engine = (sharedName != NULL) ? cnchess_engine_new_shared(sharedName, ttSizeInMB, hugePages) : cnchess_engine_new(ttSizeInMB);
+    if (engine == NULL){
+        perror((sharedName != NULL) ? sharedName : "cnchess_engine_new");
+        cnchess_position_free(pos);
+        return EXIT_FAILURE;
+    }
+
+    if (lineCount > 0){
+        lines = (struct CnchessLine*)safe_malloc(lineCount * sizeof(struct CnchessLine));
+        found = cnchess_engine_search_lines(engine, pos, &limits, lines, lineCount);
+        if (found > 0){
+            memcpy(&best, &(lines[0].moves[0]), sizeof(struct CnchessMove));
+            score = lines[0].score;
+        }
+    }
+    else {
+        found = cnchess_engine_search(engine, pos, &limits, &best, &score);
+    }
+
+    if (!found){
+        printf("bestmove none\n");
+    }
+    else {
+        cnchess_engine_stats(engine, &stats);
+        cnchess_move_to_str(&best, moveStr, sizeof(moveStr));
+        printf("bestmove %s score %d depth %u nodes %llu tthits %llu/%llu evalcache %llu/%llu", moveStr, score, stats.depth, stats.nodes, 
+            stats.ttHits, stats.ttProbes, stats.evalCacheHits, stats.evalCacheProbes);
+        if (limits.clock != NULL){
+            printf(" time %lld", stats.timeMs);
+        }
+
+        printf(" pv");
+
+        pvLen = cnchess_engine_pv(engine, pv, MAX_SEARCH_PLY);
+        for (i = 0; i < pvLen; ++i){
+            cnchess_move_to_str(&(pv[i]), moveStr, sizeof(moveStr));
+            printf(" %s", moveStr);
+        }
+
+        printf("\n");
+
+        for (k = 0; k < found && lines != NULL; ++k){
+            printf("line %lu score %d pv", (unsigned long)(k + 1), lines[k].score);
+            for (i = 0; i < lines[k].len; ++i){
+                cnchess_move_to_str(&(lines[k].moves[i]), moveStr, sizeof(moveStr));
+                printf(" %s", moveStr);
+            }
+
+            printf("\n");
+        }
+    }
+
+    free(lines);
+    cnchess_engine_free(engine);
+    cnchess_position_free(pos);
+    return EXIT_SUCCESS;
+}
+
+/* 
+    post-mortem analysis: every position of a game is searched on its own, the loss of a move is how much
+    the score of the side that played it dropped from the position before the move to the position after it.
+    losses from these on are marked "?!", "?" and "??".
+*/
+#define ANALYSE_INACCURACY 15
+#define ANALYSE_MISTAKE 40
+#define ANALYSE_BLUNDER 90
+
+/* in the average loss, a move loses at most this much, a lost general would hide everything else. */
+#define ANALYSE_AVERAGE_LOSS_CAP 200
+
+/* the transposition table all the analysis threads share, and how much of a better line is printed. */
+#define ANALYSE_TRANS_TABLE_SIZE_MB 64
+#define ANALYSE_PRINT_LINE_LEN 5
+
+/* the work shared by the analysis threads, the positions are handed out one by one. */
+struct AnalyseJob{
+    const struct ChessBoard* boards;      /* boards[i] is the position before move i, the last one is the final position. */
+    const struct GameRecord* record;
+    struct TransTable* tt;
+    struct EvalCache* evalCache;
+    unsigned int depth;                   /* plies. */
+    long long timeMs;                     /* for every position, 0 means no limit. */
+    unsigned long long nodes;
+    size_t count;
+    size_t next;                          /* the next position to search, taken atomically. */
+    struct SearchLine* results;           /* the best line of every position, with its score, down side positive. */
+    unsigned long long totalNodes;
+};
+
+/* an analysis thread, everything it needs is allocated before it starts. */
+struct AnalyseWorker{
+    struct SearchContext ctx;
+    pthread_t thread;
+    struct AnalyseJob* job;
+};
+
+static void* analyse_worker_run(void* arg){
+    struct AnalyseWorker* worker = (struct AnalyseWorker*)arg;
+    struct AnalyseJob* job = worker->job;
+    struct SearchContext* ctx = &(worker->ctx);
+    struct GameRecord played;
+    struct MoveNode best;
+    struct SearchLine* result;
+    enum PieceSide winner;
+    size_t i;
+
+    while ((i = __atomic_fetch_add(&(job->next), 1, __ATOMIC_RELAXED)) < job->count){
+        result = &(job->results[i]);
+
+        winner = check_winner(&(job->boards[i]));
+        if (winner != PS_EXTRA){
+            result->len = 0;
+            result->value = (winner == PS_DOWN) ? piece_get_value[P_DG] : piece_get_value[P_UG];
+            continue;
+        }
+
+        /* the moves before this position, for the repetition rules. */
+        played.history = job->record->history;
+        played.length = i;
+        played.capacity = job->record->capacity;
+
+        search_context_init(ctx, &(job->boards[i]), &played, job->tt);
+        ctx->evalCache = job->evalCache;
+        search_context_set_limits(ctx, job->nodes, job->timeMs, NULL);
+        result->value = board_gen_best_move(ctx, job->depth - 1, &best);
+        memcpy(result->moves, ctx->bestLine, ctx->bestLineLen * sizeof(struct MoveNode));
+        result->len = ctx->bestLineLen;
+
+        __atomic_add_fetch(&(job->totalNodes), ctx->stats.nodes, __ATOMIC_RELAXED);
+    }
+
+    return NULL;
+}
+
+/* 
+    analyse a game played from the default board and print every move annotated with its score and loss,
+    and the better move where one was missed. depth is in plies, timeMs and nodes limit every position, 0 means no limit.
+*/
+static void analyse_game(const struct GameRecord* record, unsigned int depth, long long timeMs, unsigned long long nodes, unsigned int threads){
+    assert(record != NULL && depth > 0 && threads > 0);
+
+    struct AnalyseJob job;
+    struct ChessBoard* boards = (struct ChessBoard*)safe_malloc((record->length + 1) * sizeof(struct ChessBoard));
+    struct AnalyseWorker* workers = (struct AnalyseWorker*)safe_malloc(threads * sizeof(struct AnalyseWorker));
+    struct HistoryNode hist;
+    char moveStr[MOVE_TO_STR_BUFFER_LEN];
+    unsigned long long marks[2][3] = { { 0 } };
+    long long totalLoss[2] = { 0, 0 };
+    unsigned long long moveCount[2] = { 0, 0 };
+    int win = piece_get_value[P_DG] / 2;
+    size_t i;
+    unsigned int t, started;
+
+    board_init(&(boards[0]));
+    for (i = 0; i < record->length; ++i){
+        memcpy(&(boards[i + 1]), &(boards[i]), sizeof(struct ChessBoard));
+        board_move(&(boards[i + 1]), &(record->history[i].move), &hist);
+    }
+
+    job.boards = boards;
+    job.record = record;
+    job.tt = safe_trans_table_make_new(ANALYSE_TRANS_TABLE_SIZE_MB, 0);
+    job.evalCache = (struct EvalCache*)safe_malloc(sizeof(struct EvalCache));
+    eval_cache_clear(job.evalCache);
+    job.depth = depth;
+    job.timeMs = timeMs;
+    job.nodes = nodes;
+    job.count = record->length + 1;
+    job.next = 0;
+    job.results = (struct SearchLine*)safe_malloc(job.count * sizeof(struct SearchLine));
+    job.totalNodes = 0;
+
+    long long begin = time_now_ms();
+    for (started = 0; started < threads; ++started){
+        workers[started].job = &job;
+        if (pthread_create(&(workers[started].thread), NULL, analyse_worker_run, &(workers[started])) != 0){
+            break;
+        }
+    }
+
+    /* the positions are handed out one by one, fewer threads than asked for still get through all of them. */
+    if (started < threads){
+        analyse_worker_run(&(workers[started]));
+        threads = started + 1;
+    }
+
+    for (t = 0; t < started; ++t){
+        pthread_join(workers[t].thread, NULL);
+    }
+
+    long long elapsed = time_now_ms() - begin;
+
+    printf("analysis: %lu moves, depth %u, %u threads, nodes %llu, time %lld ms\n", 
+        (unsigned long)record->length, depth, threads, job.totalNodes, elapsed);
+    printf("  ply move   eval  loss\n");
+
+    for (i = 0; i < record->length; ++i){
+        const struct MoveNode* move = &(record->history[i].move);
+        const struct SearchLine* before = &(job.results[i]);
+        int after = job.results[i + 1].value;
+        int down = (boards[i].side == PS_DOWN);
+        int isBest = (before->len > 0 && move_is_same(move, &(before->moves[0])));
+        int loss = isBest ? 0 : COMPARE_MAX(down ? before->value - after : after - before->value, 0);
+        int missedWin = !isBest && (down ? (before->value >= win && after < win) : (before->value <= -win && after > -win));
+        const char* mark = "";
+
+        if (loss >= ANALYSE_BLUNDER){
+            mark = "??";
+            ++marks[down][2];
+        }
+        else if (loss >= ANALYSE_MISTAKE){
+            mark = "?";
+            ++marks[down][1];
+        }
+        else if (loss >= ANALYSE_INACCURACY){
+            mark = "?!";
+            ++marks[down][0];
+        }
+
+        totalLoss[down] += COMPARE_MIN(loss, ANALYSE_AVERAGE_LOSS_CAP);
+        ++moveCount[down];
+
+        convert_move_to_str(move, moveStr, MOVE_TO_STR_BUFFER_LEN);
+        printf("  %3lu %s %6d %5d %-2s", (unsigned long)(i + 1), moveStr, after, loss, mark);
+
+        if ((loss >= ANALYSE_INACCURACY || missedWin) && before->len > 0){
+            printf("%s best (%d):", missedWin ? " missed win," : "", before->value);
+            print_line(before->moves, COMPARE_MIN(before->len, ANALYSE_PRINT_LINE_LEN));
+        }
+        else {
+            printf("\n");
+        }
+    }
+
+    for (t = 0; t < 2; ++t){
+        int down = (t == 0);
+        printf("%s: inaccuracies %llu, mistakes %llu, blunders %llu, average loss %.1f\n", down ? "down" : "up  ",
+            marks[down][0], marks[down][1], marks[down][2], moveCount[down] ? (double)totalLoss[down] / moveCount[down] : 0.0);
+    }
+
+    trans_table_free(job.tt);
+    free(job.evalCache);
+    free(job.results);
+    free(workers);
+    free(boards);
+}
+
+/* the number of threads analyse uses by default. */
+static unsigned int analyse_default_threads(void){
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    return (cpus > 0) ? (unsigned int)cpus : 1;
+}
+
+/*
+    analyse a game of a record file, the first one or game N, see analyse_game().
+    without a budget every position is searched as deep as the game AI searches.
+    usage: cnchess analyse FILE [game N] [depth D] [time MS] [nodes N] [threads T]
+*/
+static int run_analyse(int argc, char* argv[]){
+    const char* usage = "usage: cnchess analyse FILE [game N] [depth D] [time MS] [nodes N] [threads T]\n";
+    unsigned long long wanted = 1, games = 0, nodes = 0;
+    unsigned int depth = 0, threads = analyse_default_threads();
+    long long timeMs = 0;
+    struct RecordReader reader;
+    enum RecordResult result;
+    size_t len, i;
+    int arg, ret;
+
+    if (argc < 3){
+        fprintf(stderr, "%s", usage);
+        return EXIT_FAILURE;
+    }
+
+    for (arg = 3; arg < argc; ++arg){
+        if (arg + 1 >= argc){
+            fprintf(stderr, "%s", usage);
+            return EXIT_FAILURE;
+        }
+
+        if (strcmp(argv[arg], "game") == 0){
+            wanted = strtoull(argv[++arg], NULL, 10);
+        }
+        else if (strcmp(argv[arg], "depth") == 0){
+            depth = (unsigned int)atoi(argv[++arg]);
+        }
+        else if (strcmp(argv[arg], "time") == 0){
+            timeMs = atoll(argv[++arg]);
+        }
+        else if (strcmp(argv[arg], "nodes") == 0){
+            nodes = strtoull(argv[++arg], NULL, 10);
+        }
+        else if (strcmp(argv[arg], "threads") == 0){
+            threads = (unsigned int)atoi(argv[++arg]);
+        }
+        else {
+            fprintf(stderr, "unknown analyse option: %s\n", argv[arg]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    /* a time or node budget alone lets the search go as deep as it can. */
+    if (depth == 0){
+        depth = (timeMs > 0 || nodes > 0) ? MAX_SEARCH_PLY - 1 : CNCHESS_AI_SEARCH_DEPTH + 1;
+    }
+
+    if (!record_reader_open(&reader, argv[2])){
+        fprintf(stderr, "cannot open record file: %s\n", argv[2]);
+        return EXIT_FAILURE;
+    }
+
+    struct MoveNode* moves = (struct MoveNode*)safe_malloc(MAX_HISOTRY_BUF_LEN * sizeof(struct MoveNode));
+    while ((ret = record_reader_next_game(&reader, moves, MAX_HISOTRY_BUF_LEN, &len, &result)) != 0){
+        if (ret > 0 && ++games == wanted){
+            break;
+        }
+    }
+
+    if (ret <= 0){
+        fprintf(stderr, "there is no game %llu in %s\n", wanted, argv[2]);
+        free(moves);
+        record_reader_close(&reader);
+        return EXIT_FAILURE;
+    }
+
+    struct Game* game = safe_game_make_new();
+    for (i = 0; i < len; ++i){
+        if (!board_is_pseudo_legal(&(game->board), &(moves[i]))){
+            fprintf(stderr, "illegal move %lu in game %llu, the rest is not analysed.\n", (unsigned long)(i + 1), wanted);
+            break;
+        }
+
+        safe_game_move(game, &(moves[i]));
+    }
+
+    analyse_game(&(game->record), depth, timeMs, nodes, COMPARE_MAX(threads, 1));
+
+    game_free(game);
+    free(moves);
+    record_reader_close(&reader);
+    return EXIT_SUCCESS;
+}
+
+int main(int argc, char* argv[]){
+    cnchess_init();
+
+    if (argc > 1 && strcmp(argv[1], "bench") == 0){
+        return run_bench(argc, argv);
+    }
+
+    if (argc > 1 && strcmp(argv[1], "replay") == 0){
+        return run_replay(argc, argv);
+    }
+
+    if (argc > 1 && strcmp(argv[1], "convert") == 0){
+        return run_convert(argc, argv);
+    }
+
+    if (argc > 1 && strcmp(argv[1], "search") == 0){
+        return run_search(argc, argv);
+    }
+
+    if (argc > 1 && strcmp(argv[1], "see") == 0){
+        return run_see(argc, argv);
+    }
+
+    if (argc > 1 && strcmp(argv[1], "analyse") == 0){
+        return run_analyse(argc, argv);
+    }
+
+    /* 
+        cnchess [--record FILE] [--tt-size MB] [--shared-tt NAME] [--huge-pages] [--analyse]
+                [--time MS] [--inc MS] [--moves-to-go N] [--byoyomi MS] [--overhead MS]
+        --record logs every game played, --shared-tt keeps the transposition table in a POSIX shared memory segment,
+        so every cnchess process on the host attaching it learns from the others, and a new game keeps what was learned.
+        --huge-pages backs the table with huge pages when the kernel has them.
+        --time gives the AI a game clock instead of the fixed search depth, the AI loses when it runs out of time.
+        --analyse analyses the game when it ends, like the analyse command.
+    */
+    struct RecordWriter writer = { NULL, 0 };
+    size_t ttSizeInMB = CNCHESS_TRANS_TABLE_SIZE_MB;
+    const char* sharedName = NULL;
+    int hugePages = 0, arg;
+    struct TimeControl aiClock = { 0, 0, 0, 0, 0 };
+    long long controlMs = 0;
+    int timed = 0, analyseAtEnd = 0;
+
+    for (arg = 1; arg < argc; ++arg){
+        if (strcmp(argv[arg], "--huge-pages") == 0){
+            hugePages = 1;
+        }
+        else if (strcmp(argv[arg], "--analyse") == 0){
+            analyseAtEnd = 1;
+        }
+        else if (arg + 1 < argc && strcmp(argv[arg], "--time") == 0){
+            controlMs = atoll(argv[++arg]);
+            timed = 1;
+        }
+        else if (arg + 1 < argc && strcmp(argv[arg], "--inc") == 0){
+            aiClock.incrementMs = atoll(argv[++arg]);
+        }
+        else if (arg + 1 < argc && strcmp(argv[arg], "--moves-to-go") == 0){
+            aiClock.movesToGo = (unsigned int)atoi(argv[++arg]);
+        }
+        else if (arg + 1 < argc && strcmp(argv[arg], "--byoyomi") == 0){
+            aiClock.byoyomiMs = atoll(argv[++arg]);
+            timed = 1;
+        }
+        else if (arg + 1 < argc && strcmp(argv[arg], "--overhead") == 0){
+            aiClock.overheadMs = atoll(argv[++arg]);
+        }
+        else if (arg + 1 < argc && strcmp(argv[arg], "--record") == 0){
+            if (!record_writer_open(&writer, argv[++arg])){
+                fprintf(stderr, "cannot open record file: %s\n", argv[arg]);
+                return EXIT_FAILURE;
+            }
+        }
+        else if (arg + 1 < argc && strcmp(argv[arg], "--tt-size") == 0){
+            ttSizeInMB = (size_t)strtoull(argv[++arg], NULL, 10);
+        }
+        else if (arg + 1 < argc && strcmp(argv[arg], "--shared-tt") == 0){
+            sharedName = argv[++arg];
+        }
+        else {
+            fprintf(stderr, "usage: cnchess [--record FILE] [--tt-size MB] [--shared-tt NAME] [--huge-pages] [--analyse]"
+                            " [--time MS] [--inc MS] [--moves-to-go N] [--byoyomi MS] [--overhead MS]\n");
+            record_writer_close(&writer);
+            return EXIT_FAILURE;
+        }
+    }
+
+    unsigned int controlMoves = aiClock.movesToGo;
+    aiClock.remainingMs = controlMs;
+
+    struct TransTable* tt;
+    if (sharedName != NULL){
+        tt = trans_table_make_shared(sharedName, ttSizeInMB, hugePages);
+        if (tt == NULL){
+            perror(sharedName);
+            record_writer_close(&writer);
+            return EXIT_FAILURE;
+        }
+    }
+    else {
+        tt = safe_trans_table_make_new(ttSizeInMB, hugePages);
+    }
+
+    enum RecordResult result = RR_UNKNOWN;
+
+    struct EvalCache* evalCache = (struct EvalCache*)safe_malloc(sizeof(struct EvalCache));
+    eval_cache_clear(evalCache);
+
+    struct Game* game = safe_game_make_new();
+    struct ChessBoard* cb = &(game->board);
+    struct SearchContext* ctx = (struct SearchContext*)safe_malloc(sizeof(struct SearchContext));
+    char userInput[MAX_USER_INPUT_BUFFER_LEN];
+    char moveStr[MOVE_TO_STR_BUFFER_LEN];
+    struct MoveNode userMove, aiMove, userAdviceMove;
+    struct SearchLine adviceLines[ADVICE_LINES];
+    unsigned int aiDepth = 0;    /* the depth the AI completed for its last move, 0 if it did not search. */
+
+    board_print_to_console(cb);
+
+    while (1){
+        printf("Your move: ");
+        get_line(userInput, MAX_USER_INPUT_BUFFER_LEN);
+
+        if (strcmp(userInput, "help") == 0){
+            print_help_page();
+            board_print_to_console(cb);
+        }
+        else if (strcmp(userInput, "undo") == 0){
+            game_undo(game);
+            game_undo(game);
+            aiDepth = 0;
+            board_print_to_console(cb);
+        }
+        else if (strcmp(userInput, "quit") == 0){
+            goto EXIT_CNCHESS;
+        }
+        else if (strcmp(userInput, "exit") == 0){
+            goto EXIT_CNCHESS;
+        }
+        else if (strcmp(userInput, "remake") == 0){
+            if (writer.fp != NULL && game->record.length > 0){
+                record_writer_write_game(&writer, &(game->record), RR_UNKNOWN);
+            }
+
+            game_free(game);
+            game = safe_game_make_new();
+            cb = &(game->board);
+            if (!tt->shared){
+                trans_table_clear(tt);
+            }
+
+            eval_cache_clear(evalCache);
+            aiDepth = 0;
+
+            aiClock.remainingMs = controlMs;
+            aiClock.movesToGo = controlMoves;
+
+            printf("New cnchess started.\n");
+            board_print_to_console(cb);
+            continue;
+        }
+        else if (strcmp(userInput, "analyse") == 0){
+            analyse_game(&(game->record), CNCHESS_AI_SEARCH_DEPTH + 1, 0, 0, analyse_default_threads());
+        }
+        else if (strcmp(userInput, "advice") == 0){
+            /*
+                the transposition table still has what the AI searched for its last move, this position one ply below its root.
+                the advice stops at that depth, so the reply the AI expected comes from the table instead of a deeper search.
+            */
+            unsigned int adviceDepth = (aiDepth > 1) ? COMPARE_MIN(aiDepth - 1, CNCHESS_AI_SEARCH_DEPTH + 1) : CNCHESS_AI_SEARCH_DEPTH + 1;
+            size_t lineCount = 0, k;
+            if (!opening_book_probe(cb, &userAdviceMove)){
+                search_context_init(ctx, cb, &(game->record), tt);
+                ctx->evalCache = evalCache;
+                lineCount = board_gen_best_lines(ctx, adviceDepth - 1, adviceLines, ADVICE_LINES);
+                if (lineCount > 0){
+                    memcpy(&userAdviceMove, &(adviceLines[0].moves[0]), sizeof(struct MoveNode));
+                }
+                else {    /* out of memory for the lines, one move still helps. */
+                    board_gen_best_move(ctx, adviceDepth - 1, &userAdviceMove);
+                }
+            }
+
+            convert_move_to_str(&userAdviceMove, moveStr, MOVE_TO_STR_BUFFER_LEN);
+            printf("Maybe you can try: %s, piece is %c.\n", moveStr, piece_get_char[cb->data[userAdviceMove.beginRow][userAdviceMove.beginCol]]);
+
+            for (k = 0; k < lineCount; ++k){
+                printf("  %lu. score %5d:", (unsigned long)(k + 1), adviceLines[k].value);
+                print_line(adviceLines[k].moves, adviceLines[k].len);
+            }
+
+            int lost = check_move_loses_material(cb, &userAdviceMove);
+            if (lost > 0){
+                printf("Careful: the enemy can take it back, the exchange may cost you %d.\n", lost);
+            }
+        }
+        else{
+            if (check_input_is_a_move(userInput, strlen(userInput))){
+                convert_input_to_move(userInput, &userMove);
+                
+                if (!check_is_this_your_piece(cb, &userMove, USER_SIDE)){
+                    printf("This piece is not yours, please choose your piece.\n");
+                    continue;
+                }
+
+                if (check_rule(cb, &userMove)){
+                    if (safe_game_move(game, &userMove) == GS_DRAW_TOO_LONG){
+                        goto DRAW_CNCHESS;
+                    }
+
+                    board_print_to_console(cb);
+
+                    if (check_winner(cb) == USER_SIDE){
+                        printf("Congratulations! You win!\n");
+                        result = record_result_of_winner(USER_SIDE);
+                        goto EXIT_CNCHESS;
+                    }
+
+                    printf("AI thinking...\n");
+                    long long thinkBegin = time_now_ms();
+                    aiDepth = 0;
+                    if (!opening_book_probe(cb, &aiMove)){
+                        search_context_init(ctx, cb, &(game->record), tt);
+                        ctx->evalCache = evalCache;
+                        if (timed){
+                            search_context_set_clock(ctx, &aiClock);
+                            board_gen_best_move(ctx, MAX_SEARCH_PLY - 2, &aiMove);
+                        }
+                        else {
+                            board_gen_best_move(ctx, CNCHESS_AI_SEARCH_DEPTH, &aiMove);
+                        }
+
+                        aiDepth = ctx->stats.depth;
+                    }
+
+                    if (timed && !time_control_spend(&aiClock, time_now_ms() - thinkBegin, controlMs, controlMoves)){
+                        printf("AI has run out of time! You win!\n");
+                        result = record_result_of_winner(USER_SIDE);
+                        goto EXIT_CNCHESS;
+                    }
+
+                    convert_move_to_str(&aiMove, moveStr, MOVE_TO_STR_BUFFER_LEN);
+
+                    if (safe_game_move(game, &aiMove) == GS_DRAW_TOO_LONG){
+                        goto DRAW_CNCHESS;
+                    }
+
+                    board_print_to_console(cb);
+                    printf("AI move: %s, piece is '%c'.\n", moveStr, piece_get_char[cb->data[aiMove.endRow][aiMove.endCol]]);
+                    if (timed){
+                        printf("AI clock: %lld.%03lld s left.\n", aiClock.remainingMs / 1000, aiClock.remainingMs % 1000);
+                    }
+
+                    if (check_winner(cb) == AI_SIDE){
+                        printf("Game over! You lose!\n");
+                        result = record_result_of_winner(AI_SIDE);
+                        goto EXIT_CNCHESS;
+                    }
+                }
+                else {
+                    printf("Given move does't fit for rules, please re-enter.\n");
+                    continue;
+                }
+            }
+            else {
+                printf("Input is not a valid move nor instruction, please re-enter(try help ?).\n");
+                continue;
+            }
+        }
+    }
+
+DRAW_CNCHESS:
+    printf("Draw: You have been battling with AI for a very long time and have exceeded the max number of rounds in this game.\n");
+    result = RR_DRAW;
+
+EXIT_CNCHESS:
+    if (analyseAtEnd && game->record.length > 0){
+        analyse_game(&(game->record), CNCHESS_AI_SEARCH_DEPTH + 1, 0, 0, analyse_default_threads());
+    }
+
+    if (writer.fp != NULL){
+        record_writer_write_game(&writer, &(game->record), result);
+        record_writer_close(&writer);
+    }
+
+    game_free(game);
+    trans_table_free(tt);
+    free(evalCache);
+    free(ctx);
+    return 0;
+}
+
+#endif
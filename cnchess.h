@@ -0,0 +1,221 @@
+/*
+    libcnchess, the cnchess engine as a library.
+
+    build cnchess.c with CNCHESS_NO_MAIN defined (see the Makefile) and link libcnchess.a or libcnchess.so.
+    the library has no global mutable state except the lookup tables, which are filled once by cnchess_init().
+    positions and engines are independent objects, so many of them can be used at the same time from different threads,
+    as long as one object is never used by two threads at once.
+
+    coordinates are ICCS: file 0 - 8 is 'a' - 'i' from left to right, rank 0 - 9 from the bottom.
+    the down side (red in FEN, upper case letters) sits at ranks 0 - 4 and moves first.
+*/
+#ifndef CNCHESS_H
+#define CNCHESS_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* the max number of moves one side can have. */
+#define CNCHESS_MAX_MOVES 256
+
+/* the FEN of the start position. */
+#define CNCHESS_START_FEN "rnbakabnr/9/1c5c1/p1p1p1p1p/9/9/P1P1P1P1P/1C5C1/9/RNBAKABNR w - - 0 1"
+
+/* the longest principal variation the engine reports. */
+#define CNCHESS_MAX_PV 64
+
+/* ICCS string of a move, like "h2e2", with the terminating '\0'. */
+#define CNCHESS_MOVE_STR_LEN 5
+
+/* enough for any FEN cnchess_position_get_fen() writes. */
+#define CNCHESS_FEN_BUFFER_LEN 128
+
+enum CnchessSide{
+    CNCHESS_SIDE_UP,      /* black in FEN. */
+    CNCHESS_SIDE_DOWN     /* red in FEN, moves first. */
+};
+
+struct CnchessMove{
+    int fromFile;
+    int fromRank;
+    int toFile;
+    int toRank;
+};
+
+/* 
+    a game clock of the side to move, in milliseconds. the engine splits the time into a soft and a hard limit for the move,
+    thinks longer when the best move changes or the score drops, and stops early when one move is clearly the best.
+*/
+struct CnchessClock{
+    long long remainingMs;      /* main time left. */
+    long long incrementMs;      /* added after every move. */
+    unsigned int movesToGo;     /* moves to the next time control, 0 means the main time is for the rest of the game. */
+    long long byoyomiMs;        /* every move may use this much once the main time has run out. */
+    long long overheadMs;       /* kept back for I/O latency, the engine never plans to use it. */
+};
+
+/* result of a game in a record file. */
+enum CnchessResult{
+    CNCHESS_RESULT_UNKNOWN,    /* "*", the game was not finished. */
+    CNCHESS_RESULT_DOWN_WIN,   /* "1-0". */
+    CNCHESS_RESULT_UP_WIN,     /* "0-1". */
+    CNCHESS_RESULT_DRAW        /* "1/2-1/2". */
+};
+
+/* 
+    search limits, the search stops at the first one reached. 0 or NULL means no limit, except depth and threads.
+    with a fresh or cleared engine, a search limited by depth or nodes only gives the same result every run,
+    with any number of threads.
+*/
+struct CnchessLimits{
+    unsigned int depth;           /* plies, 0 means the depth the game uses. */
+    long long timeMs;
+    unsigned long long nodes;     /* checked at every node, the search stops after exactly this many nodes. */
+    const volatile int* stop;     /* set *stop to non zero from another thread to stop the search soon. */
+    unsigned int threads;         /* more than 1: the root moves are dealt to this many threads in a fixed way, nodes are split evenly. */
+    const struct CnchessClock* clock;    /* search by the game clock, depth 0 then means no depth limit. */
+};
+
+/* statistics of the last search of an engine. */
+struct CnchessStats{
+    unsigned long long nodes;            /* positions searched. */
+    unsigned long long generatedMoves;   /* moves produced by the move generators. */
+    unsigned int depth;                  /* the deepest iteration completed. */
+    long long timeMs;
+    unsigned long long ttProbes;         /* transposition table lookups. */
+    unsigned long long ttHits;           /* lookups that found the position, searched by this or another engine. */
+    unsigned long long evals;            /* static evaluations. */
+    unsigned long long evalLazy;         /* evaluations so far outside the search window that only material and position values were used. */
+    unsigned long long evalCacheProbes;  /* the other evaluations, looked up in the evaluation cache first. */
+    unsigned long long evalCacheHits;
+    long long evalTimeMs;                /* estimated time spent on the costly evaluation terms. */
+};
+
+/* one line of a Multi-PV search: a root move and the principal variation starting with it. */
+struct CnchessLine{
+    struct CnchessMove moves[CNCHESS_MAX_PV];
+    size_t len;
+    int score;                           /* from the side to move's view, bigger is better. */
+};
+
+/* a position and the moves played to reach it, the moves are needed for repetition rules and unmake. */
+struct CnchessPosition;
+
+/* a search engine, owns a transposition table which is kept between searches, or shares one with other processes. */
+struct CnchessEngine;
+
+/* fill the lookup tables, it is safe to call this more than once and from many threads. the functions below call it too. */
+void cnchess_init(void);
+
+/* a new position at the start position, free it with cnchess_position_free(). return NULL if out of memory. */
+struct CnchessPosition* cnchess_position_new(void);
+void cnchess_position_free(struct CnchessPosition* pos);
+
+/* set the position from a FEN string, the moves played are forgotten. return 0 if the FEN is invalid, pos is not changed then. */
+int cnchess_position_set_fen(struct CnchessPosition* pos, const char* fen);
+
+/* write the FEN of the position to buf, return 0 if len is too small. */
+int cnchess_position_get_fen(const struct CnchessPosition* pos, char* buf, size_t len);
+
+enum CnchessSide cnchess_position_side(const struct CnchessPosition* pos);
+
+/* print the board to stdout, the way the cnchess game does. */
+void cnchess_position_print(const struct CnchessPosition* pos);
+
+/*
+    legal moves of the side to move: moves that leave the own general attacked are left out.
+    write at most capacity moves, return the number of legal moves. 0 means the side to move has lost.
+*/
+size_t cnchess_position_legal_moves(struct CnchessPosition* pos, struct CnchessMove* moves, size_t capacity);
+
+/* play a move, return 0 if it is not legal, the game is too long to go on or memory runs out, pos is not changed then. */
+int cnchess_position_make_move(struct CnchessPosition* pos, const struct CnchessMove* move);
+
+/* take back the last move, return 0 if there is none. */
+int cnchess_position_unmake_move(struct CnchessPosition* pos);
+
+/* the opening book move of the position, mirrored positions are found too. return 0 if the position is not in the book. */
+int cnchess_position_book_move(struct CnchessPosition* pos, struct CnchessMove* move);
+
+/*
+    append the game played on pos to the record file path, which is made if there is none. a name ending with ".bin" gets
+    the binary format, any other one the text format, a game per line. record files keep games from the start position.
+    return 0 if pos was not played from the start position, the file can't be written, or it is a binary record
+    of another version, errno tells why.
+*/
+int cnchess_position_save(const struct CnchessPosition* pos, const char* path, enum CnchessResult result);
+
+/*
+    set pos to game number index, from 0, of the record file path, in either format. result may be NULL.
+    empty lines of a text record are not games, index counts the non-empty lines only.
+    return 0 if the file can't be read or is a binary record of another version, if there is no such game,
+    or if the game is broken or has an illegal move, pos is not changed then.
+*/
+int cnchess_position_load(struct CnchessPosition* pos, const char* path, size_t index, enum CnchessResult* result);
+
+/* parse an ICCS move like "h2e2" or "H2-E2", return 0 if str is not a move. */
+int cnchess_move_from_str(const char* str, struct CnchessMove* move);
+
+/* write a move as ICCS like "h2e2", return 0 if len is smaller than CNCHESS_MOVE_STR_LEN. */
+int cnchess_move_to_str(const struct CnchessMove* move, char* buf, size_t len);
+
+/* a new engine with a transposition table of about ttSizeInMB, free it with cnchess_engine_free(). return NULL if out of memory. */
+struct CnchessEngine* cnchess_engine_new(size_t ttSizeInMB);
+void cnchess_engine_free(struct CnchessEngine* engine);
+
+/*
+    a new engine using the transposition table in the POSIX shared memory segment shmName, like "/cnchess-tt".
+    every engine of every process on the host attaching the same name shares what the others have searched, without locks.
+    the first one creates the segment with about ttSizeInMB, the others use its size.
+    hugePages asks the kernel for transparent huge pages, see /sys/kernel/mm/transparent_hugepage/shmem_enabled.
+    the segment is kept after every process exits, until cnchess_shared_table_remove().
+    return NULL if the segment cannot be opened, was made by an incompatible build or memory runs out, errno tells why.
+*/
+struct CnchessEngine* cnchess_engine_new_shared(const char* shmName, size_t ttSizeInMB, int hugePages);
+
+/* remove a shared memory segment, processes still using it keep it until they free their engines. return 0 on failure. */
+int cnchess_shared_table_remove(const char* shmName);
+
+/* forget everything learned by previous searches, call it when starting a new game. a shared table is cleared for everyone. */
+void cnchess_engine_clear(struct CnchessEngine* engine);
+
+/*
+    set a search parameter, return 0 if there is no such parameter.
+    futility_margin_1, futility_margin_2: futility pruning margins at the last 2 plies.
+    razor_margin_2, razor_margin_3: razoring margins at 2 and 3 plies from the leaves.
+    margins are in score units (a pawn is 20), a negative margin turns the pruning off at that depth.
+    the defaults are futility_margin_1=20, futility_margin_2=40, razor_margin_2=30 and razor_margin_3=60.
+*/
+int cnchess_engine_set_option(struct CnchessEngine* engine, const char* name, int value);
+
+/*
+    search the best move for the side to move, limits may be NULL.
+    score is from the side to move's view, bigger is better, it may be NULL.
+    return 0 if the side to move has no legal move, best is not changed then.
+*/
+int cnchess_engine_search(struct CnchessEngine* engine, const struct CnchessPosition* pos, const struct CnchessLimits* limits, struct CnchessMove* best, int* score);
+
+/*
+    Multi-PV search: the lineCount best moves for the side to move, best first, each with its exact score and principal variation.
+    it is one search, the lines share the transposition table, so a position searched before, like the reply the engine
+    expected in its last search, comes back fast. threads in limits is not used.
+    return the number of lines written, fewer than lineCount when there are fewer legal moves, 0 if there is none or memory runs out.
+    the stats and the pv of the engine are those of the best line.
+*/
+size_t cnchess_engine_search_lines(struct CnchessEngine* engine, const struct CnchessPosition* pos, const struct CnchessLimits* limits,
+                                   struct CnchessLine* lines, size_t lineCount);
+
+/* statistics of the last search. */
+void cnchess_engine_stats(const struct CnchessEngine* engine, struct CnchessStats* stats);
+
+/* the principal variation of the last search, the best move first. write at most capacity moves, return its length. */
+size_t cnchess_engine_pv(const struct CnchessEngine* engine, struct CnchessMove* moves, size_t capacity);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,68 @@
+/*
+    a small libcnchess example: two engines play each other from a FEN, every search is limited by nodes and time.
+    build: make example, then run ./selfplay [FEN]
+*/
+#include <stdio.h>
+
+#include "cnchess.h"
+
+#define SELFPLAY_MAX_MOVES 200
+
+int main(int argc, char* argv[]){
+    struct CnchessPosition* pos = cnchess_position_new();
+    struct CnchessEngine* engines[2];
+    struct CnchessLimits limits = { .timeMs = 200, .nodes = 200000 };
+    struct CnchessMove moves[CNCHESS_MAX_MOVES];
+    struct CnchessMove best;
+    struct CnchessStats stats;
+    char moveStr[CNCHESS_MOVE_STR_LEN];
+    char fen[CNCHESS_FEN_BUFFER_LEN];
+    int score, ply;
+
+    if (pos == NULL){
+        fprintf(stderr, "out of memory.\n");
+        return 1;
+    }
+
+    if (!cnchess_position_set_fen(pos, (argc > 1) ? argv[1] : CNCHESS_START_FEN)){
+        fprintf(stderr, "invalid FEN.\n");
+        cnchess_position_free(pos);
+        return 1;
+    }
+
+    engines[CNCHESS_SIDE_UP] = cnchess_engine_new(16);
+    engines[CNCHESS_SIDE_DOWN] = cnchess_engine_new(16);
+    if (engines[CNCHESS_SIDE_UP] == NULL || engines[CNCHESS_SIDE_DOWN] == NULL){
+        fprintf(stderr, "out of memory.\n");
+        cnchess_engine_free(engines[CNCHESS_SIDE_UP]);
+        cnchess_engine_free(engines[CNCHESS_SIDE_DOWN]);
+        cnchess_position_free(pos);
+        return 1;
+    }
+
+    for (ply = 0; ply < SELFPLAY_MAX_MOVES; ++ply){
+        if (cnchess_position_legal_moves(pos, moves, CNCHESS_MAX_MOVES) == 0){
+            printf("%s has no legal move and loses.\n", cnchess_position_side(pos) == CNCHESS_SIDE_DOWN ? "down" : "up");
+            break;
+        }
+
+        cnchess_engine_search(engines[cnchess_position_side(pos)], pos, &limits, &best, &score);
+        cnchess_engine_stats(engines[cnchess_position_side(pos)], &stats);
+        cnchess_move_to_str(&best, moveStr, sizeof(moveStr));
+        printf("%3d. %s score %6d depth %u nodes %llu time %lld ms\n", ply + 1, moveStr, score, stats.depth, stats.nodes, stats.timeMs);
+
+        if (!cnchess_position_make_move(pos, &best)){
+            printf("the game is too long, draw.\n");
+            break;
+        }
+    }
+
+    cnchess_position_get_fen(pos, fen, sizeof(fen));
+    cnchess_position_print(pos);
+    printf("%s\n", fen);
+
+    cnchess_engine_free(engines[CNCHESS_SIDE_UP]);
+    cnchess_engine_free(engines[CNCHESS_SIDE_DOWN]);
+    cnchess_position_free(pos);
+    return 0;
+}
@@ -0,0 +1,30 @@
+#!/bin/sh
+# checks of the game record files through the `replay` and `convert` commands.
+# usage: tests/record.sh [path to cnchess]
+
+CNCHESS=${1:-./cnchess}
+DIR=$(mktemp -d)
+failed=0
+
+fail(){
+    echo "FAIL: $1"
+    failed=1
+}
+
+echo "h2e2 h9g7 h0g2 i9h9 1-0" > "$DIR/game.txt"
+"$CNCHESS" convert "$DIR/game.txt" "$DIR/game.bin" > /dev/null || fail "convert to binary"
+"$CNCHESS" replay "$DIR/game.bin" | grep -q "games 1 (1-0 1" || fail "replay of the converted binary record"
+
+# empty lines of a text record are not games, game numbers count the non-empty lines only.
+printf 'h2e2 h9g7 1-0\n\n\nb2e2 1/2-1/2\n' > "$DIR/gaps.txt"
+"$CNCHESS" replay "$DIR/gaps.txt" | grep -q "games 2 (.*) broken 0" || fail "replay counts empty lines as games"
+"$CNCHESS" analyse "$DIR/gaps.txt" game 2 depth 1 threads 1 | grep -q "^analysis: 1 moves" || fail "game 2 skips the empty lines"
+
+# a binary record of an unknown version is refused, both for reading and for appending.
+printf 'CNCR\002' > "$DIR/future.bin"
+"$CNCHESS" replay "$DIR/future.bin" > /dev/null 2>&1 && fail "replay accepts binary record version 2"
+"$CNCHESS" convert "$DIR/game.txt" "$DIR/future.bin" > /dev/null 2>&1 && fail "convert appends to binary record version 2"
+
+rm -rf "$DIR"
+[ $failed -eq 0 ] && echo "record tests passed"
+exit $failed
@@ -0,0 +1,42 @@
+#!/bin/sh
+# checks run through the `search` command, the same path the library users take.
+# usage: tests/search.sh [path to cnchess]
+
+CNCHESS=${1:-./cnchess}
+failed=0
+
+fail(){
+    echo "FAIL: $1"
+    failed=1
+}
+
+# the start position has 44 legal moves, one multi-pv line each.
+lines=$("$CNCHESS" search depth 1 multipv 64 | grep -c '^line')
+[ "$lines" -eq 44 ] || fail "start position gives $lines root moves, want 44"
+
+# every multi-pv line starts with a different root move.
+for depth in 1 2 3; do
+    firsts=$("$CNCHESS" search depth $depth multipv 8 | awk '$1 == "line" { print $6 }')
+    [ "$(echo "$firsts" | wc -l)" -eq 8 ] || fail "depth $depth gives $(echo "$firsts" | wc -l) lines, want 8"
+    [ -z "$(echo "$firsts" | sort | uniq -d)" ] || fail "depth $depth repeats root moves: $(echo "$firsts" | sort | uniq -d | tr '\n' ' ')"
+done
+
+# a node limited search gives the same best move, score, pv and counters every run, with one thread or many.
+# the threads share one evaluation cache, its hit count alone depends on timing and is left out.
+for threads in 1 4; do
+    first=$("$CNCHESS" search nodes 200000 threads $threads | sed 's/ evalcache [0-9]*\/[0-9]*//')
+    second=$("$CNCHESS" search nodes 200000 threads $threads | sed 's/ evalcache [0-9]*\/[0-9]*//')
+    [ -n "$first" ] && [ "$first" = "$second" ] || fail "threads $threads runs differ: '$first' and '$second'"
+done
+
+# perpetual check loses: the up general can only shuttle between d9 and e9, repeating the checks again must not score a draw.
+out=$("$CNCHESS" search depth 4 fen "rr1k1c3/9/9/9/9/9/9/9/4R4/5K3 w" moves e1d1 d9e9 d1e1 e9d9)
+score=$(echo "$out" | awk '{ print $4 }')
+[ "$(echo "$out" | awk '{ print $2 }')" != "e1d1" ] && [ "$score" -lt -100 ] || fail "perpetual check scores as a draw: $out"
+
+# a rook sliding along its file while it keeps attacking the same horse chases nothing new, repeating is a draw.
+out=$("$CNCHESS" search depth 1 multipv 64 fen "4k2rr/9/n8/9/9/9/9/9/R8/3K5 w" moves a1a2 e9e8 a2a1 e8e9 | grep '^line .* pv a1a2$')
+[ "$(echo "$out" | awk '{ print $4 }')" = "0" ] || fail "a kept threat counts as a chase: $out"
+
+[ $failed -eq 0 ] && echo "search tests passed"
+exit $failed
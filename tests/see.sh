@@ -0,0 +1,30 @@
+#!/bin/sh
+# checks of the static exchange evaluation through the `see` command, on boards where cannon screens and knight legs decide.
+# usage: tests/see.sh [path to cnchess]
+
+CNCHESS=${1:-./cnchess}
+failed=0
+
+fail(){
+    echo "FAIL: $1"
+    failed=1
+}
+
+# see FEN MOVE WANTED DESCRIPTION
+see(){
+    got=$("$CNCHESS" see "$1" "$2" | awk '{ print $2 }')
+    [ "$got" = "$3" ] || fail "$4: $2 gives '$got', want $3"
+}
+
+# the rook takes a pawn on e5, a rook is 100 and a pawn 20.
+see "3kc4/9/4n4/9/4p4/9/9/9/4R4/5K3 w" e1e5 -80 "the cannon takes back over its screen"
+see "3kc4/9/9/9/4p4/9/9/9/4R4/5K3 w" e1e5 20 "the cannon has no screen"
+see "3k5/9/3n5/9/4p4/9/9/9/4R4/5K3 w" e1e5 -80 "the knight takes back"
+see "3k5/9/3n5/3p5/4p4/9/9/9/4R4/5K3 w" e1e5 20 "the knight leg is blocked"
+
+# the rook was the screen of the cannon behind it, it is gone once the rook takes, unless another piece is left there.
+see "3k5/9/3n5/9/4p4/9/9/4R4/9/4CK3 w" e2e5 -80 "the cannon loses its screen"
+see "3k5/9/3n5/9/4p4/9/9/4R4/4A4/4CK3 w" e2e5 -30 "the cannon keeps a screen"
+
+[ $failed -eq 0 ] && echo "see tests passed"
+exit $failed